@@ -0,0 +1,742 @@
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "btree.h"
+
+static double ms_since(const struct timespec *before)
+{
+	struct timespec after;
+	clock_gettime(CLOCK_MONOTONIC, &after);
+	return (after.tv_nsec - before->tv_nsec) / 1000000.0 +
+		(after.tv_sec - before->tv_sec) * 1000.0;
+}
+
+// the search/replace workload of main.c, which leaves a slice per match
+static SliceTable *replace_all(const char *path, const char *pattern,
+								const char *replace)
+{
+	SliceTable *st = st_new_from_file(path);
+	if(!st)
+		return NULL;
+	size_t len = strlen(pattern), replacelen = strlen(replace);
+	size_t cap = 1024, count = 0, *matches = malloc(cap * sizeof(size_t));
+	SliceIter it;
+	st_iter_init(&it, st, 0);
+	size_t i = 0;
+	int c = st_iter_byte_inline(&it);
+	bool *matchpos = calloc(len, sizeof(bool));
+	do {
+		for(int m = len - 2; m >= 0; m--) {
+			if(matchpos[m] && c == pattern[m+1])
+				matchpos[m+1] = true;
+			matchpos[m] = false;
+		}
+		if(c == pattern[0])
+			matchpos[0] = true;
+		if(matchpos[len-1]) {
+			matchpos[len-1] = false;
+			if(count == cap)
+				matches = realloc(matches, (cap *= 2) * sizeof(size_t));
+			matches[count++] = i - (len-1);
+		}
+		i++;
+	} while((c = st_iter_next_byte_inline(&it)) != -1);
+	free(matchpos);
+
+	long delta = 0;
+	for(size_t m = 0; m < count; m++) {
+		st_delete(st, matches[m] + delta, len);
+		st_insert(st, matches[m] + delta, replace, replacelen);
+		delta += (long)replacelen - len;
+	}
+	free(matches);
+	fprintf(stderr, "replaced %zu matches, leaves: %zu, size %zu, depth %d\n",
+			count, st_node_count(st), st_size(st), st_depth(st));
+	return st;
+}
+
+static int bench_save(int argc, char **argv)
+{
+	if(argc < 4)
+		return -1;
+	SliceTable *st = replace_all(argv[1], argv[2], argv[3]);
+	if(!st)
+		return 1;
+	const char *out = "bench.out";
+	static const struct { const char *name; enum st_writer backend; }
+	writers[] = {
+		{ "writev", ST_WRITER_WRITEV },
+		{ "io_uring", ST_WRITER_URING },
+		{ "parallel", ST_WRITER_PARALLEL },
+	};
+	for(int round = 0; round < 3; round++)
+		for(size_t w = 0; w < sizeof writers / sizeof *writers; w++) {
+			st_set_writer(writers[w].backend);
+			int fd = open(out, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+			struct timespec before;
+			clock_gettime(CLOCK_MONOTONIC, &before);
+			ssize_t n = st_write(st, fd);
+			double write_ms = ms_since(&before);
+			fsync(fd);
+			printf("%-8s wrote %zd bytes in %.2f ms (%.2f ms with fsync)\n",
+					writers[w].name, n, write_ms, ms_since(&before));
+			close(fd);
+		}
+	unlink(out);
+	st_free(st);
+	return 0;
+}
+
+static bool sum_first(const char *data, size_t len, void *ctx)
+{
+	(void)len;
+	*(size_t *)ctx += (unsigned char)data[0];
+	return true;
+}
+
+// counts a byte through the out-of-line and inline byte functions
+static int bench_bytes(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	SliceIter it;
+	for(int round = 0; round < 3; round++) {
+		struct timespec before;
+		size_t calls = 0, inlined = 0;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_init(&it, st, 0);
+		for(int c = st_iter_byte(&it); c != -1; c = st_iter_next_byte(&it, 1))
+			calls += c == '\n';
+		double calls_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_init(&it, st, 0);
+		for(int c = st_iter_byte_inline(&it); c != -1;
+				c = st_iter_next_byte_inline(&it))
+			inlined += c == '\n';
+		printf("%zu newlines: st_iter_next_byte %.2f ms, inline %.2f ms\n",
+				calls, calls_ms, ms_since(&before));
+		if(calls != inlined)
+			return 1;
+	}
+	st_free(st);
+	return 0;
+}
+
+// cutting a byte out every stride bytes of a mapped file leaves one slice per
+// stride without copying, so a large file gives a deep table cheaply
+static int bench_scan(int argc, char **argv)
+{
+	if(argc < 3)
+		return -1;
+	size_t stride = strtoul(argv[2], NULL, 10);
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st || stride < 2)
+		return 1;
+	for(size_t pos = st_size(st) / stride * stride; pos > 0; pos -= stride)
+		st_delete(st, pos, 1);
+	fprintf(stderr, "leaves: %zu, size %zu, depth %d\n",
+			st_node_count(st), st_size(st), st_depth(st));
+
+	SliceIter *it = st_iter_new(st, 0);
+	for(int round = 0; round < 3; round++) {
+		struct timespec before;
+		size_t chunks = 0, sum = 0;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, 0);
+		do {
+			size_t len;
+			sum += (unsigned char)st_iter_chunk(it, &len)[0];
+			chunks++;
+		} while(st_iter_next_chunk(it));
+		double fwd_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_foreach_chunk(st, 0, st_size(st), sum_first, &sum);
+		double foreach_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, st_size(st));
+		while(st_iter_prev_chunk(it))
+			sum += (unsigned char)st_iter_byte(it);
+		double back_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, 0);
+		for(int c = st_iter_byte(it); c != -1; c = st_iter_next_byte(it, 1))
+			sum += c;
+		printf("%zu chunks: forward %.2f ms (%.1f ns/chunk), foreach %.2f ms "
+				"(%.1f ns/chunk), backward %.2f ms, bytewise %.2f ms (sum %zu)\n",
+				chunks, fwd_ms, fwd_ms * 1e6 / chunks, foreach_ms,
+				foreach_ms * 1e6 / chunks, back_ms, ms_since(&before), sum);
+	}
+	st_iter_free(it);
+	st_free(st);
+	return 0;
+}
+
+// inserts count slices too large to merge at pseudorandom positions, so
+// consecutive slices are scattered around the heap, then scans the chunks
+static int bench_frag(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	size_t count = strtoul(argv[1], NULL, 10);
+	SliceTable *st = st_new();
+	char slice[2100];
+	unsigned long seed = 1;
+	for(size_t n = 0; n < count; n++) {
+		memset(slice, 'a' + n % 26, sizeof slice);
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+		size_t slices = st_size(st) / sizeof slice;
+		size_t pos = slices ? (seed >> 33) % (slices + 1) * sizeof slice : 0;
+		st_insert(st, pos, slice, sizeof slice);
+	}
+	fprintf(stderr, "leaves: %zu, size %zu, depth %d\n",
+			st_node_count(st), st_size(st), st_depth(st));
+
+	SliceIter *it = st_iter_new(st, 0);
+	for(int round = 0; round < 5; round++) {
+		struct timespec before;
+		size_t chunks = 0, sum = 0;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, 0);
+		do {
+			size_t len;
+			sum += (unsigned char)st_iter_chunk(it, &len)[0];
+			chunks++;
+		} while(st_iter_next_chunk(it));
+		double fwd_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, st_size(st));
+		while(st_iter_prev_chunk(it))
+			sum += (unsigned char)st_iter_byte(it);
+		printf("%zu chunks: forward %.2f ms (%.1f ns/chunk), backward %.2f ms "
+				"(sum %zu)\n", chunks, fwd_ms, fwd_ms * 1e6 / chunks,
+				ms_since(&before), sum);
+	}
+	st_iter_free(it);
+	st_free(st);
+	return 0;
+}
+
+// types a character at a time with views spread over the file, keeping their
+// iterators up to date by re-seeking or with st_iter_fixup
+static int bench_fixup(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { VIEWS = 64, KEYS = 200000 };
+	for(int round = 0; round < 4; round++) {
+		bool fixup = round & 1;
+		SliceTable *st = st_new_from_file(argv[1]);
+		if(!st)
+			return 1;
+		SliceIter *its[VIEWS];
+		for(int v = 0; v < VIEWS; v++)
+			its[v] = st_iter_new(st, st_size(st) / VIEWS * v);
+		size_t cursor = st_size(st) / 3;
+		struct timespec before;
+		double edit_ms = 0, update_ms = 0;
+		for(int k = 0; k < KEYS; k++) {
+			clock_gettime(CLOCK_MONOTONIC, &before);
+			if(k % 8 == 7)
+				st_delete(st, --cursor, 1);
+			else
+				st_insert(st, cursor++, "x", 1);
+			edit_ms += ms_since(&before);
+			clock_gettime(CLOCK_MONOTONIC, &before);
+			if(fixup)
+				st_iter_fixup(its, VIEWS, k % 8 == 7 ? cursor : cursor - 1,
+								k % 8 == 7, k % 8 != 7);
+			else
+				for(int v = 0; v < VIEWS; v++) {
+					size_t pos = st_iter_pos(its[v]);
+					st_iter_to(its[v], pos > cursor ? pos + (k % 8 == 7 ? -1 : 1)
+														: pos);
+				}
+			update_ms += ms_since(&before);
+		}
+		printf("%-7s %d keys, %d views: edits %.2f ms, iterators %.2f ms\n",
+				fixup ? "fixup" : "re-seek", KEYS, VIEWS, edit_ms, update_ms);
+		for(int v = 0; v < VIEWS; v++)
+			st_iter_free(its[v]);
+		st_free(st);
+	}
+	return 0;
+}
+
+// walks the whole table step codepoints at a time in each direction
+static int bench_cp(int argc, char **argv)
+{
+	if(argc < 3)
+		return -1;
+	size_t step = strtoul(argv[2], NULL, 10);
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st || step == 0)
+		return 1;
+	SliceIter *it = st_iter_new(st, 0);
+	for(int round = 0; round < 3; round++) {
+		struct timespec before;
+		size_t steps = 0;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		st_iter_to(it, 0);
+		while(st_iter_next_cp(it, step) != -1)
+			steps++;
+		double fwd_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		while(st_iter_prev_cp(it, step) != -1)
+			steps++;
+		double back_ms = ms_since(&before);
+		printf("%zu steps: forward %.2f ms (%.2f GB/s), backward %.2f ms\n",
+				steps, fwd_ms, st_size(st) / fwd_ms / 1e6, back_ms);
+	}
+	st_iter_free(it);
+	st_free(st);
+	return 0;
+}
+
+// jumps from the start to each of a few lines spread over the table and back
+static int bench_line(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	SliceIter *it = st_iter_new(st, 0);
+	size_t lines = 0;
+	while(st_iter_next_line(it, 1))
+		lines++;
+	fprintf(stderr, "%zu lines\n", lines);
+	for(int round = 0; round < 3; round++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		for(size_t target = lines / 8; target < lines; target += lines / 8) {
+			st_iter_to(it, 0);
+			st_iter_next_line(it, target);
+		}
+		double fwd_ms = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		for(size_t target = lines / 8; target < lines; target += lines / 8) {
+			st_iter_to(it, st_size(st));
+			st_iter_prev_line(it, target);
+		}
+		printf("goto line: forward %.2f ms, backward %.2f ms\n",
+				fwd_ms, ms_since(&before));
+	}
+	st_iter_free(it);
+	st_free(st);
+	return 0;
+}
+
+// edits spread over the table, then random line lookups, scanning and with
+// st_enable_lines
+static int bench_lineindex(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { EDITS = 20000, LOOKUPS = 200 };
+	for(int round = 0; round < 4; round++) {
+		bool indexed = round & 1;
+		SliceTable *st = st_new_from_file(argv[1]);
+		if(!st)
+			return 1;
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if(indexed)
+			st_enable_lines(st);
+		double enable_ms = ms_since(&before);
+		srand(1);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		for(int k = 0; k < EDITS; k++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(st);
+			if(k % 4 == 3)
+				st_delete(st, pos, 1);
+			else
+				st_insert(st, pos, k % 2 ? "\n" : "x", 1);
+		}
+		double edit_ms = ms_since(&before);
+		size_t lines = st_pos_to_line(st, st_size(st)) + 1, sum = 0;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		for(int l = 0; l < LOOKUPS; l++)
+			sum += st_pos_to_line(st, st_line_to_pos(st, rand() % lines));
+		printf("%-7s %zu lines: enable %.2f ms, %d edits %.2f ms, "
+				"%d lookups %.2f ms (%zu)\n", indexed ? "indexed" : "scan",
+				lines, enable_ms, EDITS, edit_ms, LOOKUPS, ms_since(&before),
+				sum);
+		st_free(st);
+	}
+	return 0;
+}
+
+// opens a file and asks for its last line while it's counted in the
+// background, then once it's been counted
+static int bench_linejob(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	struct timespec before;
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	StLineJob *job = st_count_lines_async(st);
+	if(!job)
+		return 1;
+	printf("open and start: %.2f ms\n", ms_since(&before));
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	size_t lines = st_pos_to_line(st, st_size(st));
+	printf("%zu lines while counting: %.2f ms\n", lines, ms_since(&before));
+	st_line_job_wait(job);
+	printf("counted: %.2f ms\n", ms_since(&before));
+	for(int round = 0; round < 3; round++) {
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		size_t pos = st_line_to_pos(st, lines / 2);
+		lines = st_pos_to_line(st, st_size(st));
+		printf("middle line at %zu, %zu lines: %.2f ms\n", pos, lines,
+				ms_since(&before));
+	}
+	st_free(st);
+	return 0;
+}
+
+// maps random positions to a line and UTF-16 column and back, as for
+// language server diagnostics, scanning and with the metrics kept
+static int bench_lsp(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { DIAGS = 100 };
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	for(int round = 0; round < 2; round++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if(round) {
+			st_enable_lines(st);
+			st_add_metric(st, &st_utf16);
+		}
+		double enable_ms = ms_since(&before);
+		srand(1);
+		bool ok = true;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		for(int d = 0; d < DIAGS; d++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(st);
+			pos = st_cp_to_pos(st, pos, 0); // on a codepoint
+			size_t line = st_pos_to_line(st, pos);
+			size_t start = st_line_to_pos(st, line);
+			size_t col = st_pos_to_utf16(st, start, pos);
+			ok &= st_utf16_to_pos(st, st_line_to_pos(st, line), col) == pos;
+		}
+		printf("%-7s: enable %.2f ms, %d diagnostics %.2f ms%s\n",
+				round ? "metrics" : "scan", enable_ms, DIAGS, ms_since(&before),
+				ok ? "" : " MISMATCH");
+	}
+	st_free(st);
+	return 0;
+}
+
+// types with marks spread over the table, then replaces every match of a
+// byte as one batch and as single edits
+static int bench_marks(int argc, char **argv)
+{
+	if(argc < 3)
+		return -1;
+	size_t count = strtoul(argv[2], NULL, 10);
+	enum { KEYS = 100000 };
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	StMarks *marks = st_marks_new(st);
+	for(size_t m = 0; m < count; m++)
+		st_mark_add(marks, st_size(st) / count * m, m & ST_MARK_RIGHT);
+	struct timespec before;
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	size_t cursor = st_size(st) / 3;
+	for(int k = 0; k < KEYS; k++)
+		st_insert(st, cursor++, "x", 1);
+	printf("%zu marks: %d keys %.2f ms\n", count, KEYS, ms_since(&before));
+	// every '<' in the first MiB
+	size_t n = 0, len = MIN(st_size(st), 1<<20);
+	char *text = st_read_alloc0(st, 0, len);
+	struct st_edit *edits = malloc(len * sizeof *edits);
+	for(size_t i = 0; i < len; i++)
+		if(text[i] == '<')
+			edits[n++] = (struct st_edit){ i, 1, "&lt;", 4 };
+	for(int round = 0; round < 2; round++) {
+		SliceTable *copy = st_clone(st);
+		StMarks *m = st_marks_new(copy);
+		for(size_t i = 0; i < count; i++)
+			st_mark_add(m, st_size(copy) / count * i, 0);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if(round)
+			st_edit_batch(copy, edits, n);
+		else
+			for(size_t e = n; e-- > 0; ) {
+				st_delete(copy, edits[e].pos, 1);
+				st_insert(copy, edits[e].pos, "&lt;", 4);
+			}
+		printf("%zu replacements %s: %.2f ms\n", n,
+				round ? "batched" : "one by one", ms_since(&before));
+		st_marks_free(m);
+		st_free(copy);
+	}
+	free(edits);
+	free(text);
+	st_marks_free(marks);
+	st_free(st);
+	return 0;
+}
+
+static bool count_deco(size_t start, size_t end, size_t id, int flags,
+						void *ctx)
+{
+	(void)start, (void)end, (void)id, (void)flags;
+	++*(size_t *)ctx;
+	return true;
+}
+
+// types with a decoration every few bytes, against marks at their starts and
+// ends, then renders viewports
+static int bench_decos(int argc, char **argv)
+{
+	if(argc < 3)
+		return -1;
+	size_t count = strtoul(argv[2], NULL, 10);
+	enum { KEYS = 100000, VIEWS = 10000, VIEW = 4096 };
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st || !count)
+		return 1;
+	SliceTable *marked = st_clone(st);
+	StMarks *marks = st_marks_new(marked);
+	size_t step = st_size(st) / count;
+	for(size_t d = 0; d < count; d++) {
+		st_deco_add(st, d * step, d * step + step / 2, d, 0);
+		st_mark_add(marks, d * step, 0);
+		st_mark_add(marks, d * step + step / 2, 0);
+	}
+	SliceTable *tables[] = { st, marked };
+	for(int t = 0; t < 2; t++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		srand(1);
+		for(int k = 0; k < KEYS; k++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(tables[t]);
+			st_insert(tables[t], pos, "x", 1);
+		}
+		printf("%zu %s: %d keys %.2f ms\n", count,
+				t ? "marks" : "decorations", KEYS, ms_since(&before));
+	}
+	struct timespec before;
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	size_t seen = 0;
+	for(int v = 0; v < VIEWS; v++) {
+		size_t pos = (size_t)rand() * 7919 % st_size(st);
+		st_foreach_deco(st, pos, pos + VIEW, count_deco, &seen);
+	}
+	printf("%d viewports of %d bytes: %zu decorations %.2f ms\n", VIEWS, VIEW,
+			seen, ms_since(&before));
+	st_marks_free(marks);
+	st_free(marked);
+	st_free(st);
+	return 0;
+}
+
+// the longest line after each edit, scanning and from line length summaries
+static int bench_longest(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { EDITS = 200 };
+	for(int keep = 0; keep < 2; keep++) {
+		SliceTable *st = st_new_from_file(argv[1]);
+		if(!st)
+			return 1;
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if(keep)
+			st_add_metric(st, &st_line_lengths);
+		size_t longest = st_longest_line(st, 0, st_size(st));
+		printf("%s: longest line %zu in %.2f ms\n",
+				keep ? "summaries" : "scanning", longest, ms_since(&before));
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		srand(1);
+		for(int e = 0; e < EDITS; e++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(st);
+			if(e % 2)
+				st_delete(st, pos, 1);
+			else
+				st_insert(st, pos, "\n", 1);
+			longest += st_longest_line(st, 0, st_size(st));
+		}
+		printf("%d edits: %.2f ms (%zu)\n", EDITS, ms_since(&before), longest);
+		st_free(st);
+	}
+	return 0;
+}
+
+// display columns of random positions, stepping codepoints from the start
+// of the line (counting each as one column) and with st_iter_visual_col,
+// then moves a cursor down through the file keeping its column
+static int bench_columns(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { QUERIES = 10000, TAB = 8 };
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	for(int fast = 0; fast < 2; fast++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		srand(1);
+		size_t sum = 0;
+		for(int q = 0; q < QUERIES; q++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(st);
+			SliceIter it;
+			st_iter_init(&it, st, pos);
+			if(fast) {
+				sum += st_iter_visual_col(&it, TAB);
+				continue;
+			}
+			SliceIter line = it;
+			st_iter_prev_line(&line, 0);
+			for(size_t col = 0; ; col++) {
+				if(line.pos >= pos) {
+					sum += col;
+					break;
+				}
+				if(st_iter_byte(&line) == '\t')
+					col += TAB - 1 - col % TAB;
+				st_iter_next_cp(&line, 1);
+			}
+		}
+		printf("%s: %d columns %.2f ms (%zu)\n", fast ? "vectors" : "stepping",
+				QUERIES, ms_since(&before), sum);
+	}
+	struct timespec before;
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	SliceIter it;
+	st_iter_init(&it, st, 0);
+	size_t col = 40, lines = 0;
+	while(st_iter_next_line(&it, 1)) {
+		st_iter_to_visual_col(&it, col, TAB);
+		lines++;
+	}
+	printf("cursor down %zu lines at column %zu: %.2f ms\n", lines, col,
+			ms_since(&before));
+	st_free(st);
+	return 0;
+}
+
+static int bench_graphemes(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	for(int graphemes = 0; graphemes < 2; graphemes++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		SliceIter it;
+		st_iter_init(&it, st, 0);
+		size_t n = 0;
+		while(graphemes ? st_iter_next_grapheme(&it, 1) : st_iter_next_cp(&it, 1) >= 0)
+			n++;
+		double fwd = ms_since(&before);
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		while(graphemes ? st_iter_prev_grapheme(&it, 1) : st_iter_prev_cp(&it, 1) >= 0)
+			;
+		printf("%s: %zu forward %.2f ms, backward %.2f ms\n",
+				graphemes ? "graphemes" : "codepoints", n, fwd, ms_since(&before));
+	}
+	st_free(st);
+	return 0;
+}
+
+static int bench_brackets(int argc, char **argv)
+{
+	if(argc < 2)
+		return -1;
+	enum { FRAG = 10000, QUERIES = 200, EDITS = 1000 };
+	SliceTable *st = st_new_from_file(argv[1]);
+	if(!st)
+		return 1;
+	for(int e = 0; e < FRAG; e++)
+		st_insert(st, (size_t)rand() * 7919 % st_size(st), "()", 2);
+	for(int kept = 0; kept < 2; kept++) {
+		struct timespec before;
+		clock_gettime(CLOCK_MONOTONIC, &before);
+		if(kept) {
+			st_add_metric(st, &st_brackets);
+			printf("summarizing: %.2f ms\n", ms_since(&before));
+			clock_gettime(CLOCK_MONOTONIC, &before);
+		}
+		srand(1);
+		size_t sum = 0, open, close;
+		for(int q = 0; q < QUERIES; q++) {
+			size_t pos = (size_t)rand() * 7919 % st_size(st);
+			if(st_enclosing_brackets(st, pos, &open, &close))
+				sum += close - open;
+		}
+		printf("%s: %d enclosing blocks %.2f ms (%zu)\n",
+				kept ? "summaries" : "scanning", QUERIES, ms_since(&before), sum);
+	}
+	struct timespec before;
+	clock_gettime(CLOCK_MONOTONIC, &before);
+	size_t sum = 0, open, close;
+	for(int e = 0; e < EDITS; e++) {
+		size_t pos = (size_t)rand() * 7919 % st_size(st);
+		st_insert(st, pos, "[]", 2);
+		if(st_enclosing_brackets(st, pos + 1, &open, &close))
+			sum += close - open;
+	}
+	printf("%d edits and queries: %.2f ms (%zu)\n", EDITS, ms_since(&before),
+			sum);
+	st_free(st);
+	return 0;
+}
+
+static const struct {
+	const char *name;
+	int (*run)(int argc, char **argv);
+	const char *usage;
+} benchmarks[] = {
+	{ "save", bench_save, "<file> <search pattern> <replacement pattern>" },
+	{ "bytes", bench_bytes, "<file>" },
+	{ "scan", bench_scan, "<file> <stride>" },
+	{ "frag", bench_frag, "<slices>" },
+	{ "fixup", bench_fixup, "<file>" },
+	{ "cp", bench_cp, "<file> <codepoints per step>" },
+	{ "line", bench_line, "<file>" },
+	{ "lineindex", bench_lineindex, "<file>" },
+	{ "linejob", bench_linejob, "<file>" },
+	{ "lsp", bench_lsp, "<file>" },
+	{ "marks", bench_marks, "<file> <marks>" },
+	{ "decos", bench_decos, "<file> <decorations>" },
+	{ "longest", bench_longest, "<file>" },
+	{ "columns", bench_columns, "<file>" },
+	{ "graphemes", bench_graphemes, "<file>" },
+	{ "brackets", bench_brackets, "<file>" },
+};
+
+int main(int argc, char **argv)
+{
+	st_print_struct_sizes();
+	for(size_t b = 0; argc > 1 && b < sizeof benchmarks/sizeof *benchmarks; b++)
+		if(!strcmp(argv[1], benchmarks[b].name)) {
+			int ret = benchmarks[b].run(argc - 1, argv + 1);
+			if(ret >= 0)
+				return ret;
+		}
+	fprintf(stderr, "usage:\n");
+	for(size_t b = 0; b < sizeof benchmarks/sizeof *benchmarks; b++)
+		fprintf(stderr, "  %s %s %s\n", argv[0], benchmarks[b].name,
+				benchmarks[b].usage);
+	return 1;
+}
@@ -3,7 +3,10 @@
  */
 
 #include <assert.h>
+#include <errno.h>
+#include <libgen.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -12,13 +15,32 @@
 
 #ifdef __unix__
 	#include <fcntl.h>
+	#include <poll.h>
 	#include <unistd.h>
 	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <sys/uio.h>
 #else
 	#error TODO file mapping for non-unix systems
 #endif
 
-#include "st.h"
+#ifdef __linux__
+	#include <sys/sendfile.h>
+	#include <sys/syscall.h>
+	#if __has_include(<linux/io_uring.h>)
+		#include <linux/io_uring.h>
+		#define USE_URING
+	#endif
+#endif
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
+#include "btree.h"
+#include "graphemes.h"
 
 #define HIGH_WATER (1<<12)
 #define LOW_WATER (HIGH_WATER/2)
@@ -35,32 +57,146 @@ struct block {
 	enum blktype type;
 	char *data;
 	size_t len; // needed for mmap
+	struct blockfd *file; // MMAP: so output can copy from the file in-kernel
+	_Atomic(struct chunksums *) chunks; // by metric
 	struct block *next; // for freeing later
 };
 
-#define NODESIZE (256 - sizeof(atomic_int)) // close enough
+// a mapped file's descriptor. Saving over the file moves the mapping onto a
+// copy and swaps the descriptor, so readers hold a reference while they use it
+struct blockfd {
+	atomic_int refc;
+	int fd;
+};
+
+// small enough for bracket matching to scan one, as brackets are dense
+#define CHUNK (1<<16)
+
+// a metric's summary per CHUNK of a block, measured on first use by whoever
+// shares the block. Edits inside large slices then measure at most two
+// partial chunks, and seeks pass whole ones
+struct chunksums {
+	const StMetric *m;
+	struct chunksums *next;
+	atomic_size_t data[]; // fields per chunk, the last + 1 once measured
+};
+
+#define NODESIZE (256 - sizeof(atomic_int) - sizeof(void *)) // close enough
 #define PER_B (sizeof(size_t) + sizeof(void *))
 #define B ((int)(NODESIZE / PER_B))
 struct node {
 	atomic_int refc;
+	_Atomic(struct sums *) sums; // NULL unless tables have metrics
 	size_t spans[B];
 	void *child[B]; // in leaves (level 1), these are data pointers
 };
 
+// the metrics of a table. summaries are laid out by set, so a set is never
+// changed but replaced, and clones share the id
+struct metricset {
+	unsigned long id;
+	int n;
+	int stride; // size_ts per slot
+	int off[ST_MAX_METRICS];
+	const StMetric *m[ST_MAX_METRICS];
+};
+
+// summaries of a node's slots for one metric set. Nodes shared by tables with
+// different sets keep a list, which only grows while the node is shared
+struct sums {
+	struct sums *next;
+	unsigned long set;
+	bool stale; // the node was edited since it was summarized
+	size_t size;
+	// leaves: the slices summarized. Large slices are immutable views of
+	// blocks, so they needn't be measured again while they're in the leaf
+	const void *child[B];
+	size_t spans[B];
+	size_t data[]; // [B+1][stride]: each slot's, then the node's
+};
+
 struct slicetable {
 	struct node *root;
 	struct block *blocks;
 	int levels; // we could use tagging but blocks need to be tracked anyways
+	unsigned long shape; // bumped when nodes or slots move, see st_iter_fixup
+	struct metricset *metrics; // NULL when there are none
+	StMarks *marks; // attached mark arrays, see st_marks_new
+	struct deconode *decos; // NULL when there are none
+};
+
+struct stmarks {
+	SliceTable *st; // NULL once it's freed
+	StMarks *next; // of st's others
+	// sorted by position
+	size_t n, cap;
+	size_t *pos;
+	size_t *id;
+	unsigned char *flags;
+	// by id: the index of the mark, DELETED + its flags once deleted with its
+	// text, or FREED + the next free id + 1
+	size_t nids;
+	size_t *index;
+	size_t freeids;
+};
+
+#define DELETED (SIZE_MAX/2)
+#define FREED (DELETED + 256)
+
+#define DECO_B 16
+
+// decorations in order of their starts, in a persistent B-tree like the
+// slices. Each start is relative to the one before it, so edits only change
+// the first decoration after them and those they touch
+struct deconode {
+	atomic_int refc;
+	int n; // filled below DECO_B in between operations
+	bool leaf;
+	// of each decoration or subtree: its last start and its farthest end,
+	// relative to the start before it
+	size_t span[DECO_B];
+	size_t reach[DECO_B];
+	union {
+		struct deconode *child[DECO_B];
+		size_t id[DECO_B];
+	};
+	unsigned char flags[DECO_B];
 };
 
 /* blocks */
 
+static pthread_mutex_t file_lock = PTHREAD_MUTEX_INITIALIZER; // block->file
+
+static struct blockfd *block_file_get(const struct block *block)
+{
+	pthread_mutex_lock(&file_lock);
+	struct blockfd *f = block->file;
+	atomic_fetch_add_explicit(&f->refc, 1, memory_order_relaxed);
+	pthread_mutex_unlock(&file_lock);
+	return f;
+}
+
+static void block_file_put(struct blockfd *f)
+{
+	if(atomic_fetch_sub_explicit(&f->refc, 1, memory_order_acq_rel) == 1) {
+		close(f->fd);
+		free(f);
+	}
+}
+
 static void free_block(struct block *block)
 {
 	switch(block->type) {
-		case MMAP: munmap(block->data, block->len); break;
+		case MMAP:
+			munmap(block->data, block->len);
+			block_file_put(block->file);
+			break;
 		case HEAP: free(block->data);
 	}
+	for(struct chunksums *c = block->chunks, *next; c; c = next) {
+		next = c->next;
+		free(c);
+	}
 	free(block);
 }
 
@@ -89,10 +225,35 @@ static void block_delete(char *block, size_t blocklen, size_t off, size_t len)
 	memmove(block + off, block + off + len, blocklen - off - len);
 }
 
+// returns the file mapping DATA points into, if any
+static const struct block *mmap_block(const SliceTable *st, const char *data)
+{
+	for(const struct block *b = st->blocks; b; b = b->next)
+		if(b->type == MMAP && data >= b->data && data < b->data + b->len)
+			return b;
+	return NULL;
+}
+
+// returns the block of a slice larger than HIGH_WATER, if it has one
+static struct block *slice_block(const SliceTable *st, const char *data)
+{
+	for(struct block *b = st->blocks; b; b = b->next)
+		if(data >= b->data && data < b->data + b->len)
+			return b;
+	return NULL;
+}
+
 /* tree utilities */
 
 static void print_node(const struct node *node, int level);
 bool st_check_invariants(const SliceTable *st);
+static bool check_recurse(struct node *root, int height, int level);
+static const size_t *sums_update(const SliceTable *st, struct node *node,
+								int level);
+static void marks_update(StMarks *marks, const struct st_edit *edits, size_t n);
+static void decos_update(SliceTable *st, size_t pos, size_t deleted,
+						size_t len);
+static void deco_drop(struct deconode *node);
 
 static void node_clrslots(struct node *node, int from, int to)
 {
@@ -107,10 +268,41 @@ static struct node *new_node(void)
 {
 	struct node *node = malloc(sizeof *node);
 	node_clrslots(node, 0, B);
+	atomic_init(&node->sums, NULL);
 	atomic_store_explicit(&node->refc, 1, memory_order_relaxed);
 	return node;
 }
 
+static void free_sums(struct sums *sums)
+{
+	while(sums) {
+		struct sums *next = sums->next;
+		free(sums);
+		sums = next;
+	}
+}
+
+static void free_node(struct node *node)
+{
+	free_sums(atomic_load_explicit(&node->sums, memory_order_relaxed));
+	free(node);
+}
+
+// n.b. the copy is stale
+static struct sums *copy_sums(const struct node *node)
+{
+	struct sums *copy = NULL, **tail = &copy;
+	for(const struct sums *s = atomic_load_explicit(&node->sums,
+						memory_order_acquire); s; s = s->next) {
+		*tail = malloc(s->size);
+		memcpy(*tail, s, s->size);
+		(*tail)->stale = true;
+		tail = &(*tail)->next;
+	}
+	*tail = NULL;
+	return copy;
+}
+
 // sums the spans of entries in node, up to fill
 static size_t node_sum(const struct node *node, int fill)
 {
@@ -148,14 +340,14 @@ void drop_node(struct node *root, int level)
 			for(int i = 0; i < node_fill(root, 0); i++)
 				if(root->spans[i] <= HIGH_WATER)
 					free(root->child[i]); // free small allocations
-			free(root);
+			free_node(root);
 		}
 	} else // inner node
 		if(atomic_fetch_sub_explicit(&root->refc,1,memory_order_release)==1) {
 			atomic_thread_fence(memory_order_acquire);
 			for(int i = 0; i < node_fill(root, 0); i++)
 				drop_node(root->child[i], level - 1);
-			free(root);
+			free_node(root);
 		}
 }
 
@@ -166,21 +358,24 @@ static void incref(atomic_int *refc)
 	atomic_fetch_add_explicit(refc, 1, memory_order_relaxed);
 }
 
-static void ensure_node_editable(struct node **nodeptr, int level)
+// returns whether node was copied
+static bool ensure_node_editable(struct node **nodeptr, int level)
 {
 	struct node *node = *nodeptr;
 	if(atomic_load_explicit(&node->refc, memory_order_acquire) != 1) {
 		struct node *copy = malloc(sizeof *copy);
 		memcpy(copy, node, sizeof *copy);
 		atomic_store_explicit(&copy->refc, 1, memory_order_relaxed);
+		atomic_init(&copy->sums, copy_sums(node));
 		// in a leaf, copy small data blocks as we modify them inplace
+		// n.b. node stays untouched, other threads may be reading it
 		int fill = node_fill(node, 0);
 		if(level == 1) {
 			for(int i = 0; i < fill; i++)
 				if(node->spans[i] <= HIGH_WATER) {
-					char *copy = malloc(HIGH_WATER);
-					memcpy(copy, node->child[i], node->spans[i]);
-					node->child[i] = copy;
+					char *data = malloc(HIGH_WATER);
+					memcpy(data, node->child[i], node->spans[i]);
+					copy->child[i] = data;
 				}
 		} else
 			for(int i = 0; i < fill; i++)
@@ -188,7 +383,12 @@ static void ensure_node_editable(struct node **nodeptr, int level)
 
 		drop_node(node, level);
 		*nodeptr = copy;
+		return true;
 	}
+	for(struct sums *s = atomic_load_explicit(&node->sums,
+						memory_order_relaxed); s; s = s->next)
+		s->stale = true;
+	return false;
 }
 
 /* simple */
@@ -223,6 +423,10 @@ SliceTable *st_new(void)
 	st->root = new_node();
 	st->blocks = NULL;
 	st->levels = 1;
+	st->shape = 0;
+	st->metrics = NULL;
+	st->marks = NULL;
+	st->decos = NULL;
 	return st;
 }
 
@@ -244,19 +448,28 @@ SliceTable *st_new_from_file(const char *path)
 		if(read(fd, data, len) != len) {
 			free(data);
 			free(st);
+			close(fd);
 			return NULL;
 		}
+		close(fd);
 		st->blocks = NULL;
 	} else {
 		data = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
-		close(fd);
-		if(data == MAP_FAILED) {
+		struct block *init = malloc(sizeof(struct block));
+		struct blockfd *file = malloc(sizeof *file);
+		if(data == MAP_FAILED || !init || !file) {
+			if(data != MAP_FAILED)
+				munmap(data, len);
+			free(init);
+			free(file);
 			free(st);
+			close(fd);
 			return NULL;
 		}
-		struct block *init = malloc(sizeof(struct block));
+		*file = (struct blockfd){ .refc = 1, .fd = fd };
 		*init = (struct block){
-			.type = MMAP, .refc = 1, .data = data, .len = len, .next = NULL
+			.type = MMAP, .refc = 1, .data = data, .len = len, .file = file,
+			.chunks = NULL, .next = NULL
 		};
 		st->blocks = init;
 	}
@@ -265,24 +478,48 @@ SliceTable *st_new_from_file(const char *path)
 	leaf->child[0] = data;
 	st->root = (struct node *)leaf;
 	st->levels = 1;
+	st->shape = 0;
+	st->metrics = NULL;
+	st->marks = NULL;
+	st->decos = NULL;
 	return st;
 }
 
 void st_free(SliceTable *st)
 {
+	for(StMarks *m = st->marks; m; m = m->next)
+		m->st = NULL;
 	drop_node(st->root, st->levels);
 	drop_block(st->blocks);
+	deco_drop(st->decos);
+	free(st->metrics);
 	free(st);
 }
 
 SliceTable *st_clone(const SliceTable *st)
 {
 	SliceTable *clone = malloc(sizeof *clone);
+	if(!clone)
+		return NULL;
 	clone->levels = st->levels;
+	clone->shape = 0;
 	clone->root = st->root;
 	clone->blocks = st->blocks;
+	clone->metrics = NULL;
+	clone->marks = NULL;
+	clone->decos = st->decos;
+	if(st->metrics) {
+		if(!(clone->metrics = malloc(sizeof *clone->metrics))) {
+			free(clone);
+			return NULL;
+		}
+		*clone->metrics = *st->metrics;
+	}
 	incref(&st->root->refc);
-	incref(&st->blocks->refc);
+	if(st->blocks)
+		incref(&st->blocks->refc);
+	if(st->decos)
+		incref(&st->decos->refc);
 	return clone;
 }
 
@@ -356,6 +593,7 @@ static void slotmove(struct node *n, int to, int from, int count)
 static struct node *split_node(struct node *node, int offset)
 {
 	struct node *split = new_node();
+	atomic_init(&split->sums, copy_sums(node)); // to find the slices moved
 	int count = B - offset;
 	memcpy(&split->spans[0], &node->spans[offset], count * sizeof(size_t));
 	memcpy(&split->child[0], &node->child[offset], count * sizeof(void *));
@@ -408,7 +646,7 @@ size_t merge_boundary(struct node **lptr, int lfill)
 // root(j) **MUST** be editable and its slices must have been moved already
 void node_remove(struct node *root, int fill, int j)
 {
-	free(root->child[j]); // slices shifted over, no need for full drop
+	free_node(root->child[j]); // slices shifted over, no need for full drop
 	size_t count = fill - (j+1);
 	slotmove(root, j, j+1, count);
 	node_clrslots(root, fill - 1, fill);
@@ -424,13 +662,22 @@ static long edit_recurse(SliceTable *st, int level, struct node *root,
 						leaf_case base_case, void *ctx,
 						struct node **split, size_t *splitsize)
 {
-	if(level == 1)
-		return base_case((void*)root, pos, span, (void*)split, splitsize, ctx);
-	else { // level > 1: inner node recursion
+	if(level == 1) {
+		// slices that keep their slot were at most edited in place, and
+		// a freed buffer may come back from malloc in another slot
+		void *old[B];
+		memcpy(old, root->child, sizeof old);
+		long delta = base_case((void*)root, pos, span, (void*)split,
+								splitsize, ctx);
+		if(*split || memcmp(old, root->child, sizeof old))
+			st->shape++;
+		return delta;
+	} else { // level > 1: inner node recursion
 		struct node *childsplit = NULL;
 		size_t childsize = 0;
 		int i = node_offset(root, &pos);
-		ensure_node_editable((struct node **)&root->child[i], level - 1);
+		if(ensure_node_editable((struct node **)&root->child[i], level - 1))
+			st->shape++;
 
 		long delta = edit_recurse(st, level - 1, root->child[i], pos, span,
 								base_case, ctx, &childsplit, &childsize);
@@ -438,6 +685,7 @@ static long edit_recurse(SliceTable *st, int level, struct node *root,
 		root->spans[i] += delta;
 		delta = *span; // is used to update split. reset it now for parents
 		if(childsize) {
+			st->shape++;
 			if(childsplit) { // overflow: attempt to insert childsplit at i+1
 				i++;
 				int fill = node_fill(root, i);
@@ -560,6 +808,7 @@ static long insert_within_slice(struct node *leaf, int fill,
 		memcpy(&spans[i+newfill], &leaf->spans[i+tmpfill-2], count*sizeof(size_t));
 		memcpy(&blocks[i+newfill], &leaf->child[i+tmpfill-2], count*sizeof(char *));
 		struct node *right_split = new_node();
+		atomic_init(&right_split->sums, copy_sums(leaf));
 		// n.b. we must compute delta directly since merging moves the insert
 		size_t oldsum = node_sum(leaf, fill) + right_span;
 		size_t new_node_fill = B/2 + 1; // B=5 6,7 -> 3,4 in right
@@ -618,6 +867,7 @@ static long insert_leaf(struct node *leaf, size_t pos, long *span,
 			new->type = HEAP;
 			new->len = len;
 			atomic_store_explicit(&new->refc, 1, memory_order_relaxed);
+			new->chunks = NULL;
 			new->next = st->blocks;
 			st->blocks = new; // still pointing, no refc update
 		} else {
@@ -662,7 +912,8 @@ bool st_insert(SliceTable *st, size_t pos, const char *data, size_t len)
 	long span = (long)len;
 	struct insert_ctx ctx = { .data = data, .st = st };
 
-	ensure_node_editable(&st->root, st->levels);
+	if(ensure_node_editable(&st->root, st->levels))
+		st->shape++;
 	edit_recurse(st, st->levels, st->root, pos, &span, &insert_leaf, &ctx,
 				&split, &splitsize);
 	// handle root underflow
@@ -670,8 +921,9 @@ bool st_insert(SliceTable *st, size_t pos, const char *data, size_t len)
 		st_dbg("handling root underflow\n");
 		struct node *oldroot = st->root;
 		st->root = st->root->child[0];
-		free(oldroot);
+		free_node(oldroot);
 		st->levels--;
+		st->shape++;
 	}
 	// handle root split
 	if(split) {
@@ -683,7 +935,13 @@ bool st_insert(SliceTable *st, size_t pos, const char *data, size_t len)
 		newroot->child[1] = split;
 		st->root = newroot;
 		st->levels++;
+		st->shape++;
 	}
+	if(st->metrics)
+		sums_update(st, st->root, st->levels);
+	for(StMarks *m = st->marks; m; m = m->next)
+		marks_update(m, &(struct st_edit){ .pos = pos, .len = len }, 1);
+	decos_update(st, pos, 0, len);
 	return true;
 }
 
@@ -824,7 +1082,8 @@ static long delete_leaf(struct node *leaf, size_t pos, long *span,
 				// was large, now small needs to be copied
 				if(leaf->spans[end] <= HIGH_WATER) {
 					char *new = malloc(HIGH_WATER);
-					memcpy(new, leaf->child[end], leaf->spans[end]);
+					memcpy(new, (char *)leaf->child[end] + len,
+							leaf->spans[end]);
 					leaf->child[end] = new;
 				} else
 					leaf->child[end] += len;
@@ -863,10 +1122,12 @@ bool st_delete(SliceTable *st, size_t pos, size_t len)
 		return true;
 
 	st_dbg("st_delete at pos %zd of len %zd\n", pos, len);
+	struct st_edit edit = { .pos = pos, .deleted = len };
 	struct node *split = NULL;
 	size_t splitsize;
 	// we only need to ensure root uniqueness once
-	ensure_node_editable(&st->root, st->levels);
+	if(ensure_node_editable(&st->root, st->levels))
+		st->shape++;
 	do {
 		long remaining = -len;
 		// n.b. remaining = bytes *left* to delete.
@@ -881,8 +1142,9 @@ bool st_delete(SliceTable *st, size_t pos, size_t len)
 			st_dbg("handling root underflow\n");
 			struct node *oldroot = st->root;
 			st->root = st->root->child[0];
-			free(oldroot);
+			free_node(oldroot);
 			st->levels--;
+			st->shape++;
 		}
 		// handle root split
 		if(split) {
@@ -894,31 +1156,623 @@ bool st_delete(SliceTable *st, size_t pos, size_t len)
 			newroot->child[1] = split;
 			st->root = newroot;
 			st->levels++;
+			st->shape++;
 		}
-		assert(st_check_invariants(st));
+		// summaries catch up below
+		assert(check_recurse(st->root, st->levels, st->levels));
 	} while(len > 0);
+	if(st->metrics)
+		sums_update(st, st->root, st->levels);
+	for(StMarks *m = st->marks; m; m = m->next)
+		marks_update(m, &edit, 1);
+	decos_update(st, pos, edit.deleted, 0);
+	assert(st_check_invariants(st));
 	return true;
 }
 
-/* iterator */
+/* marks */
 
-struct stackentry {
-	struct node *node;
-	int idx;
+StMarks *st_marks_new(SliceTable *st)
+{
+	StMarks *marks = calloc(1, sizeof *marks);
+	if(!marks)
+		return NULL;
+	marks->st = st;
+	marks->next = st->marks;
+	marks->freeids = SIZE_MAX;
+	st->marks = marks;
+	return marks;
+}
+
+void st_marks_free(StMarks *marks)
+{
+	if(marks->st) {
+		StMarks **m = &marks->st->marks;
+		while(*m != marks)
+			m = &(*m)->next;
+		*m = marks->next;
+	}
+	free(marks->pos);
+	free(marks->id);
+	free(marks->flags);
+	free(marks->index);
+	free(marks);
+}
+
+static void mark_put(StMarks *marks, size_t i, size_t pos, size_t id,
+					unsigned char flags)
+{
+	marks->pos[i] = pos;
+	marks->id[i] = id;
+	marks->flags[i] = flags;
+	marks->index[id] = i;
+}
+
+// the first mark at or after pos
+static size_t mark_search(const StMarks *marks, size_t from, size_t pos)
+{
+	size_t lo = from, hi = marks->n;
+	while(lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+		if(marks->pos[mid] < pos)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+size_t st_mark_add(StMarks *marks, size_t pos, int flags)
+{
+	if(marks->n == marks->cap) {
+		size_t cap = marks->cap ? marks->cap * 2 : 64;
+		size_t *p = realloc(marks->pos, cap * sizeof *p);
+		if(p)
+			marks->pos = p;
+		size_t *id = realloc(marks->id, cap * sizeof *id);
+		if(id)
+			marks->id = id;
+		unsigned char *f = realloc(marks->flags, cap);
+		if(f)
+			marks->flags = f;
+		if(!p || !id || !f)
+			return SIZE_MAX;
+		marks->cap = cap;
+	}
+	size_t id = marks->freeids;
+	if(id == SIZE_MAX) {
+		size_t *index = realloc(marks->index, (marks->nids+1) * sizeof *index);
+		if(!index)
+			return SIZE_MAX;
+		marks->index = index;
+		id = marks->nids++;
+	} else
+		marks->freeids = marks->index[id] - FREED - 1;
+	size_t i = mark_search(marks, 0, pos);
+	memmove(&marks->pos[i+1], &marks->pos[i], (marks->n-i) * sizeof(size_t));
+	memmove(&marks->id[i+1], &marks->id[i], (marks->n-i) * sizeof(size_t));
+	memmove(&marks->flags[i+1], &marks->flags[i], marks->n - i);
+	marks->n++;
+	for(size_t j = i+1; j < marks->n; j++)
+		marks->index[marks->id[j]] = j;
+	mark_put(marks, i, pos, id, flags);
+	return id;
+}
+
+void st_mark_remove(StMarks *marks, size_t id)
+{
+	size_t i = marks->index[id];
+	if(i < DELETED) {
+		memmove(&marks->pos[i], &marks->pos[i+1], (marks->n-i-1) * sizeof(size_t));
+		memmove(&marks->id[i], &marks->id[i+1], (marks->n-i-1) * sizeof(size_t));
+		memmove(&marks->flags[i], &marks->flags[i+1], marks->n - i - 1);
+		marks->n--;
+		for(size_t j = i; j < marks->n; j++)
+			marks->index[marks->id[j]] = j;
+	}
+	marks->index[id] = FREED + marks->freeids + 1;
+	marks->freeids = id;
+}
+
+bool st_mark_move(StMarks *marks, size_t id, size_t pos)
+{
+	size_t i = marks->index[id];
+	int flags = i < DELETED ? marks->flags[i] : (int)(i - DELETED);
+	st_mark_remove(marks, id);
+	// reuses the id just freed
+	return st_mark_add(marks, pos, flags) == id;
+}
+
+size_t st_mark_pos(const StMarks *marks, size_t id)
+{
+	size_t i = marks->index[id];
+	return i < DELETED ? marks->pos[i] : SIZE_MAX;
+}
+
+const size_t *st_marks_sorted(const StMarks *marks, size_t *n)
+{
+	*n = marks->n;
+	return marks->pos;
+}
+
+// moves the marks over edits as if they were applied front to back, in one
+// pass. Runs of marks between edits shift in bulk. Those in an edit move to
+// its start (or are deleted), then after its text if ST_MARK_RIGHT, which can
+// leave them out of order with the edits next to it. So they're inserted back
+// in place
+static void marks_update(StMarks *marks, const struct st_edit *edits, size_t n)
+{
+	size_t *pos = marks->pos;
+	size_t i = 0, w = 0; // read, write
+	size_t delta = 0; // of the edits so far, mod 2^64
+	for(size_t e = 0; ; e++) {
+		size_t end = e < n ? mark_search(marks, i, edits[e].pos) : marks->n;
+		if(w == i) {
+			for(size_t j = i; j < end; j++)
+				pos[j] += delta;
+		} else {
+			for(size_t j = i; j < end; j++)
+				pos[w + j - i] = pos[j] + delta;
+			memmove(&marks->id[w], &marks->id[i], (end - i) * sizeof(size_t));
+			memmove(&marks->flags[w], &marks->flags[i], end - i);
+			for(size_t j = w; j < w + end - i; j++)
+				marks->index[marks->id[j]] = j;
+		}
+		w += end - i;
+		i = end;
+		if(e == n)
+			break;
+		const struct st_edit *ed = &edits[e];
+		size_t start = ed->pos + delta; // where the edit is now
+		for(; i < marks->n && pos[i] <= ed->pos + ed->deleted; i++) {
+			size_t id = marks->id[i];
+			unsigned char flags = marks->flags[i];
+			if(flags & ST_MARK_DELETE && pos[i] > ed->pos &&
+					pos[i] < ed->pos + ed->deleted) {
+				marks->index[id] = DELETED + flags;
+				continue;
+			}
+			size_t p = start;
+			size_t next = start + ed->len; // where the next edit is if adjacent
+			for(size_t f = e; ; f++) {
+				if(flags & ST_MARK_RIGHT)
+					p += edits[f].len;
+				if(f+1 == n || edits[f+1].pos != edits[f].pos + edits[f].deleted
+						|| p != next)
+					break;
+				next += edits[f+1].len;
+			}
+			size_t j = w++;
+			for(; j > 0 && pos[j-1] > p; j--)
+				mark_put(marks, j, pos[j-1], marks->id[j-1], marks->flags[j-1]);
+			mark_put(marks, j, p, id, flags);
+		}
+		delta += ed->len - ed->deleted;
+	}
+	marks->n = w;
+}
+
+bool st_edit_batch(SliceTable *st, const struct st_edit *edits, size_t n)
+{
+	// all or nothing: past this, no edit can fail
+	for(size_t e = 0; e < n; e++) {
+		size_t limit = e+1 < n ? edits[e+1].pos : st_size(st);
+		if(edits[e].pos > limit || edits[e].deleted > limit - edits[e].pos)
+			return false;
+	}
+	// back to front, so the positions stay valid. Marks and decorations then
+	// move as if the edits were applied front to back, marks in one pass and
+	// decorations once per replacement rather than per deletion and insertion
+	StMarks *marks = st->marks;
+	struct deconode *decos = st->decos;
+	st->marks = NULL;
+	st->decos = NULL;
+	for(size_t e = n; e-- > 0; ) {
+		st_delete(st, edits[e].pos, edits[e].deleted);
+		st_insert(st, edits[e].pos, edits[e].data, edits[e].len);
+	}
+	st->marks = marks;
+	st->decos = decos;
+	for(StMarks *m = marks; m; m = m->next)
+		marks_update(m, edits, n);
+	size_t delta = 0; // of the edits so far, mod 2^64
+	for(size_t e = 0; e < n; e++) {
+		decos_update(st, edits[e].pos + delta, edits[e].deleted, edits[e].len);
+		delta += edits[e].len - edits[e].deleted;
+	}
+	return true;
+}
+
+/* decorations */
+
+static struct deconode *deco_new(bool leaf)
+{
+	struct deconode *node = malloc(sizeof *node);
+	if(!node)
+		return NULL;
+	atomic_store_explicit(&node->refc, 1, memory_order_relaxed);
+	node->n = 0;
+	node->leaf = leaf;
+	return node;
+}
+
+static void deco_drop(struct deconode *node)
+{
+	if(node && atomic_fetch_sub_explicit(&node->refc, 1,
+										memory_order_release) == 1) {
+		atomic_thread_fence(memory_order_acquire);
+		if(!node->leaf)
+			for(int i = 0; i < node->n; i++)
+				deco_drop(node->child[i]);
+		free(node);
+	}
+}
+
+// returns false if node is shared and copying it failed
+static bool deco_editable(struct deconode **nodeptr)
+{
+	struct deconode *node = *nodeptr;
+	if(atomic_load_explicit(&node->refc, memory_order_acquire) != 1) {
+		struct deconode *copy = malloc(sizeof *copy);
+		if(!copy)
+			return false;
+		memcpy(copy, node, sizeof *copy);
+		atomic_store_explicit(&copy->refc, 1, memory_order_relaxed);
+		if(!node->leaf)
+			for(int i = 0; i < node->n; i++)
+				incref(&node->child[i]->refc);
+		deco_drop(node);
+		*nodeptr = copy;
+	}
+	return true;
+}
+
+// node's span and reach as an entry of its parent
+static void deco_sum(const struct deconode *node, size_t *span, size_t *reach)
+{
+	size_t s = 0, r = 0;
+	for(int i = 0; i < node->n; i++) {
+		r = MAX(r, s + node->reach[i]);
+		s += node->span[i];
+	}
+	*span = s;
+	*reach = r;
+}
+
+static void deco_move(struct deconode *dst, int to, const struct deconode *src,
+						int from, int count)
+{
+	memmove(&dst->span[to], &src->span[from], count * sizeof(size_t));
+	memmove(&dst->reach[to], &src->reach[from], count * sizeof(size_t));
+	if(src->leaf)
+		memmove(&dst->id[to], &src->id[from], count * sizeof(size_t));
+	else
+		memmove(&dst->child[to], &src->child[from], count * sizeof(void *));
+	memmove(&dst->flags[to], &src->flags[from], count);
+}
+
+// opens slot i
+static void deco_open(struct deconode *node, int i)
+{
+	deco_move(node, i + 1, node, i, node->n - i);
+	node->n++;
+}
+
+// moves half of node's entries into right, a new node of the same kind.
+// n.b. relative offsets need no adjusting when splitting or merging
+static void deco_split(struct deconode *node, struct deconode *right)
+{
+	right->n = node->n / 2;
+	node->n -= right->n;
+	deco_move(right, 0, node, node->n, right->n);
+}
+
+// appends right's entries to left, freeing right
+static void deco_merge(struct deconode *left, struct deconode *right)
+{
+	deco_move(left, left->n, right, 0, right->n);
+	left->n += right->n;
+	free(right);
+}
+
+// inserts after the decorations starting at or before start. base is the
+// start before node. Sets split to node's new right sibling if it split.
+// Returns false if memory ran out, leaving the decorations as they were
+static bool deco_insert(struct deconode **nodeptr, size_t base, size_t start,
+						size_t end, size_t id, int flags,
+						struct deconode **split)
+{
+	*split = NULL;
+	if(!deco_editable(nodeptr))
+		return false;
+	struct deconode *node = *nodeptr;
+	// allocated up front, so that nothing changes unless everything can
+	struct deconode *right = NULL;
+	if(node->n == DECO_B - 1 && !(right = deco_new(node->leaf)))
+		return false;
+	int i = 0;
+	while(i < node->n && base + node->span[i] <= start)
+		base += node->span[i++];
+	if(node->leaf) {
+		size_t gap = start - base;
+		if(i < node->n) {
+			node->span[i] -= gap;
+			node->reach[i] -= gap;
+		}
+		deco_open(node, i);
+		node->span[i] = gap;
+		node->reach[i] = end - base;
+		node->id[i] = id;
+		node->flags[i] = flags;
+	} else {
+		if(i == node->n) // append to the last child
+			base -= node->span[--i];
+		struct deconode *childsplit;
+		if(!deco_insert(&node->child[i], base, start, end, id, flags,
+						&childsplit)) {
+			free(right);
+			return false;
+		}
+		deco_sum(node->child[i], &node->span[i], &node->reach[i]);
+		if(childsplit) {
+			deco_open(node, i + 1);
+			node->child[i+1] = childsplit;
+			deco_sum(childsplit, &node->span[i+1], &node->reach[i+1]);
+		}
+	}
+	if(node->n == DECO_B)
+		deco_split(node, *split = right);
+	else
+		free(right);
+	return true;
+}
+
+// moves the start of node's first decoration by delta. Returns false if
+// memory ran out partway
+static bool deco_shift(struct deconode **nodeptr, size_t delta)
+{
+	if(!deco_editable(nodeptr))
+		return false;
+	struct deconode *node = *nodeptr;
+	node->span[0] += delta;
+	node->reach[0] += delta;
+	return node->leaf || deco_shift(&node->child[0], delta);
+}
+
+static bool deco_overlaps(size_t start, size_t end, size_t from, size_t to)
+{
+	// empty decorations overlap where they are
+	return start < to && (end > from || start >= from);
+}
+
+// an edit replacing deleted bytes at pos with len bytes, or the removal of
+// decorations with id overlapping [pos, pos+deleted)
+struct decowalk {
+	bool remove;
+	size_t pos, deleted, len, id;
+	// the last start passed, before and after
+	size_t prev, newprev;
+	size_t removed;
+	bool done;
+	bool failed; // out of memory. The nodes are left whole, but misplaced
 };
 
-#define STACKSIZE 3
-struct sliceiter {
-	size_t span; // span of current slice
-	size_t off; // offset into slice
-	char *data;
-	size_t pos; // absolute position
-	struct node *leaf;
-	int node_offset;
-	struct stackentry stack[STACKSIZE];
-	SliceTable *st;
+// starts in the deleted text move to its start, so the replacement is inside
+// any decoration starting there
+static size_t deco_start(const struct decowalk *w, size_t start)
+{
+	if(w->remove || start < w->pos)
+		return start;
+	else if(start < w->pos + w->deleted)
+		return w->pos;
+	return start - w->deleted + w->len;
+}
+
+// ends in the deleted text move to the end of the replacement
+static size_t deco_end(const struct decowalk *w, size_t start, size_t end,
+						int flags)
+{
+	if(start == end)
+		return deco_start(w, start);
+	else if(w->remove || end < w->pos || end == w->pos && !(flags&ST_DECO_GROW))
+		return end;
+	return MAX(end, w->pos + w->deleted) - w->deleted + w->len;
+}
+
+static bool deco_removed(const struct decowalk *w, size_t start, size_t end,
+						size_t id, int flags)
+{
+	size_t to = w->pos + w->deleted;
+	if(w->remove)
+		return (w->id == ST_DECO_ANY || id == w->id) &&
+			deco_overlaps(start, end, w->pos, to);
+	return flags & ST_DECO_DELETE && w->deleted && w->pos <= start &&
+		end <= to && (start < end || w->pos < start && start < to);
+}
+
+// applies w to the decorations in node it concerns, i.e. those overlapping
+// the range and for edits the first one after it, whose offset changes. The
+// ones passed over move by the same amount as the start before them
+static void deco_walk(struct decowalk *w, struct deconode **nodeptr)
+{
+	if(!deco_editable(nodeptr)) {
+		w->failed = true;
+		return;
+	}
+	struct deconode *node = *nodeptr;
+	size_t to = w->pos + w->deleted;
+	int i, j; // read and write
+	for(i = j = 0; i < node->n && !w->done && !w->failed; i++) {
+		size_t base = w->prev, span = node->span[i], reach = node->reach[i];
+		if(node->leaf) {
+			size_t start = base + span, end = base + reach;
+			if(w->remove && start >= to)
+				break;
+			w->prev = start;
+			if(deco_removed(w, start, end, node->id[i], node->flags[i])) {
+				w->removed++;
+				continue;
+			}
+			size_t newstart = deco_start(w, start);
+			node->span[j] = newstart - w->newprev;
+			node->reach[j] = deco_end(w, start, end, node->flags[i]) - w->newprev;
+			node->id[j] = node->id[i];
+			node->flags[j++] = node->flags[i];
+			w->newprev = newstart;
+			w->done = start >= to;
+		} else if(base < to && base + reach >= w->pos ||
+				!w->remove && base + span >= to) {
+			deco_walk(w, &node->child[i]);
+			struct deconode *child = node->child[i];
+			if(child->n == 0) {
+				deco_drop(child);
+				continue;
+			}
+			// keep nodes from emptying out
+			if(j > 0 && child->n < DECO_B/4 &&
+					node->child[j-1]->n + child->n < DECO_B &&
+					deco_editable(&node->child[j-1])) {
+				deco_merge(node->child[j-1], child);
+				j--;
+			} else
+				node->child[j] = child;
+			deco_sum(node->child[j], &node->span[j], &node->reach[j]);
+			j++;
+		} else if(base >= to)
+			break;
+		else {
+			size_t delta = deco_start(w, base) - w->newprev;
+			if(delta && !deco_shift(&node->child[i], delta))
+				w->failed = true;
+			node->span[j] = span + delta;
+			node->reach[j] = reach + delta;
+			node->child[j++] = node->child[i];
+			w->prev = base + span;
+			w->newprev = deco_start(w, w->prev);
+		}
+	}
+	if(i < node->n && !w->failed) {
+		w->done = true;
+		// the rest stay where they are relative to the last start passed
+		size_t delta = deco_start(w, w->prev) - w->newprev;
+		w->newprev += delta;
+		if(delta && !node->leaf && !deco_shift(&node->child[i], delta))
+			w->failed = true;
+		node->span[i] += delta;
+		node->reach[i] += delta;
+	}
+	deco_move(node, j, node, i, node->n - i);
+	node->n = j + node->n - i;
+}
+
+static void deco_apply(SliceTable *st, struct decowalk *w)
+{
+	deco_walk(w, &st->decos);
+	struct deconode *root = st->decos;
+	if(w->failed) { // none rather than misplaced ones
+		deco_drop(root);
+		st->decos = NULL;
+		return;
+	}
+	while(!root->leaf && root->n == 1) {
+		st->decos = root->child[0];
+		free(root);
+		root = st->decos;
+	}
+	if(root->n == 0) {
+		free(root);
+		st->decos = NULL;
+	}
+}
+
+static void decos_update(SliceTable *st, size_t pos, size_t deleted,
+						size_t len)
+{
+	if(st->decos)
+		deco_apply(st, &(struct decowalk){
+			.pos = pos, .deleted = deleted, .len = len
+		});
+}
+
+bool st_deco_add(SliceTable *st, size_t start, size_t end, size_t id,
+				int flags)
+{
+	if(start > end || end > st_size(st))
+		return false;
+	if(!st->decos && !(st->decos = deco_new(true)))
+		return false;
+	// as in deco_insert, for the root splitting
+	struct deconode *root = NULL, *split;
+	if(st->decos->n == DECO_B - 1 && !(root = deco_new(false)))
+		return false;
+	if(!deco_insert(&st->decos, 0, start, end, id, flags, &split)) {
+		free(root);
+		return false;
+	}
+	if(split) {
+		root->n = 2;
+		root->child[0] = st->decos;
+		root->child[1] = split;
+		deco_sum(st->decos, &root->span[0], &root->reach[0]);
+		deco_sum(split, &root->span[1], &root->reach[1]);
+		st->decos = root;
+	} else
+		free(root);
+	return true;
+}
+
+size_t st_deco_remove(SliceTable *st, size_t from, size_t to, size_t id)
+{
+	if(!st->decos || from >= to)
+		return 0;
+	struct decowalk w = {
+		.remove = true, .pos = from, .deleted = to - from, .id = id
+	};
+	deco_apply(st, &w);
+	return w.removed;
+}
+
+struct decoquery {
+	size_t from, to;
+	st_deco_cb cb;
+	void *ctx;
+	bool stopped;
 };
 
+// returns whether to go on
+static bool deco_visit(const struct deconode *node, size_t base,
+						struct decoquery *q)
+{
+	for(int i = 0; i < node->n; base += node->span[i++]) {
+		if(node->leaf) {
+			size_t start = base + node->span[i], end = base + node->reach[i];
+			if(start >= q->to)
+				return false;
+			if(deco_overlaps(start, end, q->from, q->to) &&
+					!q->cb(start, end, node->id[i], node->flags[i], q->ctx)) {
+				q->stopped = true;
+				return false;
+			}
+		} else if(base >= q->to)
+			return false;
+		else if(base + node->reach[i] >= q->from &&
+				!deco_visit(node->child[i], base, q))
+			return false;
+	}
+	return true;
+}
+
+bool st_foreach_deco(const SliceTable *st, size_t from, size_t to,
+					st_deco_cb cb, void *ctx)
+{
+	struct decoquery q = { .from = from, .to = to, .cb = cb, .ctx = ctx };
+	if(st->decos)
+		deco_visit(st->decos, 0, &q);
+	return !q.stopped;
+}
+
+/* iterator */
+
 size_t st_iter_size(void) {
 	return sizeof(struct sliceiter);
 }
@@ -933,15 +1787,15 @@ SliceIter *st_iter_to(SliceIter *it, size_t pos)
 		pos -= off_end;
 
 	struct node *node = it->st->root;
-	int level = it->st->levels;
+	int level = it->levels = it->st->levels;
+	it->shape = it->st->shape;
+	assert(level <= ST_MAXLEVELS);
 	while(level > 1) {
 		int i = 0;
 		while(pos && pos >= node->spans[i])
 			pos -= node->spans[i++];
 		st_dbg("iter_to: found i: %d at level %d\n", i, level);
-		int stackidx = level - 2; // level 2 goes at stack[0], etc.
-		if(stackidx < STACKSIZE)
-			it->stack[stackidx] = (struct stackentry){ node, i };
+		it->stack[level - 2] = (struct st_stackentry){ node, i };
 
 		node = node->child[i];
 		level--;
@@ -954,8 +1808,9 @@ SliceIter *st_iter_to(SliceIter *it, size_t pos)
 		pos -= leaf->spans[i++];
 
 	it->node_offset = i;
-	it->span = leaf->spans[i];
+	it->span = size > 0 ? leaf->spans[i] : 0; // so we're off end if empty
 	it->off = pos;
+	it->data = NULL;
 	st_dbg("iter_to at leaf: i: %d, pos %zd\n", i, pos);
 
 	if(size > 0) {
@@ -971,24 +1826,40 @@ SliceIter *st_iter_to(SliceIter *it, size_t pos)
 
 SliceIter *st_iter_init(SliceIter *it, SliceTable *st, size_t pos) {
 	it->st = st;
+	it->pinned = false;
 	return st_iter_to(it, pos);
 }
 
 SliceIter *st_iter_new(SliceTable *st, size_t pos)
 {
 	SliceIter *it = malloc(sizeof *it);
+	if(!it)
+		return NULL;
 	return st_iter_init(it, st, pos);
 }
 
-int iter_stacksize(SliceIter *it)
+SliceIter *st_iter_new_pinned(const SliceTable *st, size_t pos)
 {
-	return MIN(it->st->levels - 1, STACKSIZE);
+	// the clone shares st's nodes and blocks, which edits to st copy on write
+	SliceTable *clone = st_clone(st);
+	if(!clone)
+		return NULL;
+	SliceIter *it = st_iter_new(clone, pos);
+	if(!it) {
+		st_free(clone);
+		return NULL;
+	}
+	it->pinned = true;
+	return it;
 }
 
 void st_iter_free(SliceIter *it)
 {
 	// We shouldn't have to manage reference counting of nodes given the
 	// invalidation upon freeing/modification of the corresponding slicetable.
+	// Pinned iterators own a clone, which does that for us
+	if(it && it->pinned)
+		st_free(it->st);
 	free(it);
 }
 
@@ -1000,11 +1871,44 @@ static bool iter_off_end(const SliceIter *it)
 	return it->off == it->span;
 }
 
+// whether the iterator's slice is still where the path taken to it leads.
+// Unless nodes or slots moved since, that is the same slice. If it was
+// edited in place and kept its span, the bytes after the edit stayed put
+// within it. Off end iterators may have had text appended
+static bool iter_path_valid(const SliceIter *it)
+{
+	if(it->shape != it->st->shape || iter_off_end(it))
+		return false;
+	const struct node *leaf = it->leaf;
+	int i = it->node_offset;
+	// a buffer can be edited in place and keep its span
+	return leaf->child[i] == it->data - it->off && leaf->spans[i] == it->span;
+}
+
+void st_iter_fixup(SliceIter **its, size_t n,
+					size_t pos, size_t deleted, size_t inserted)
+{
+	for(size_t k = 0; k < n; k++) {
+		SliceIter *it = its[k];
+		if(it->pinned)
+			continue;
+		if(it->pos >= pos && it->pos < pos + deleted) {
+			st_iter_to(it, pos);
+			continue;
+		}
+		size_t newpos = it->pos < pos ? it->pos : it->pos - deleted + inserted;
+		if(iter_path_valid(it))
+			it->pos = newpos;
+		else
+			st_iter_to(it, newpos);
+	}
+}
+
 bool st_iter_next_chunk(SliceIter *it)
 {
 	int i = it->node_offset;
 	struct node *leaf = it->leaf;
-	it->pos += leaf->spans[i] - it->off;
+	it->pos += it->span - it->off;
 	// fast path: same leaf
 	if(i < B-1 && leaf->spans[i+1] != ULONG_MAX) {
 		it->node_offset++;
@@ -1013,223 +1917,2655 @@ bool st_iter_next_chunk(SliceIter *it)
 		it->data = leaf->child[i+1];
 		return true;
 	}
-	int si = 0;
-	struct stackentry *s = &it->stack[si];
-	while(si < iter_stacksize(it) && s->idx < B-1 &&
-			s->node->spans[s->idx+1] == ULONG_MAX)
-		s++, si++;
-	// note: condition below is false if off-end
-	if(si < iter_stacksize(it)) {
-		it->stack[si].idx++;
-		while(--si >= 0) {
-			it->stack[si].node = it->stack[si+1].node->child[0];
-			it->stack[si].idx = 0;
+	// climb to the nearest ancestor with a next child
+	int si = 0, top = it->st->levels - 1;
+	struct st_stackentry *stack = it->stack;
+	while(si < top && (stack[si].idx == B-1 ||
+						!stack[si].node->child[stack[si].idx+1]))
+		si++;
+	if(si == top) { // off end: stay at the end of the last chunk
+		if(it->off < it->span) {
+			it->data += it->span - it->off;
+			it->off = it->span;
 		}
-		int leaf_idx = it->stack[0].idx;
-		it->leaf = (struct node *)it->stack[0].node->child[leaf_idx];
-		it->node_offset = 0;
-		it->span = it->leaf->spans[0];
-		it->off = 0;
-		it->data = it->leaf->child[0];
-		return true;
-	} else {
-		st_dbg("gave up. scanning from root for %zd\n", it->pos);
-		st_iter_to(it, it->pos);
-		return !iter_off_end(it);
+		return false;
+	}
+	stack[si].idx++;
+	// then descend its leftmost path
+	while(si > 0) {
+		struct node *child = stack[si].node->child[stack[si].idx];
+		stack[--si] = (struct st_stackentry){ child, 0 };
+	}
+	it->leaf = stack[0].node->child[stack[0].idx];
+	it->node_offset = 0;
+	it->span = it->leaf->spans[0];
+	it->off = 0;
+	it->data = it->leaf->child[0];
+	return true;
+}
+
+bool st_iter_prev_chunk(SliceIter *it)
+{
+	int i = it->node_offset;
+	struct node *leaf = it->leaf;
+	if(it->pos == it->off) { // only true in first chunk
+		it->off = it->pos = 0;
+		it->data = leaf->child[0];
+		return false;
+	}
+	it->pos -= it->off + 1; // = 0 when [X][X|...
+	// fast path: same leaf
+	if(i > 0) {
+		it->node_offset--;
+		it->span = it->leaf->spans[i-1];
+		it->off = it->span - 1;
+		it->data = (char *)leaf->child[i-1] + it->off;
+		return true;
+	}
+	// climb to the nearest ancestor with a previous child, which exists as
+	// we aren't in the first chunk
+	int si = 0;
+	struct st_stackentry *stack = it->stack;
+	while(stack[si].idx == 0)
+		si++;
+	assert(si < it->st->levels - 1);
+	stack[si].idx--;
+	// then descend its rightmost path
+	while(si > 0) {
+		struct node *child = stack[si].node->child[stack[si].idx];
+		stack[--si] = (struct st_stackentry){ child, node_fill(child, 0) - 1 };
+	}
+	leaf = stack[0].node->child[stack[0].idx];
+	int fill = node_fill(leaf, 0);
+	it->leaf = leaf;
+	it->node_offset = fill - 1;
+	it->span = leaf->spans[fill-1];
+	it->off = it->span - 1;
+	it->data = (char *)leaf->child[fill-1] + it->off;
+	return true;
+}
+
+char *st_iter_chunk(const SliceIter *it, size_t *len)
+{
+	*len = it->span;
+	return it->data - it->off;
+}
+
+size_t st_iter_read(SliceIter *it, size_t len, char *buf)
+{
+	size_t done = 0;
+	while(done < len && !iter_off_end(it)) {
+		size_t left = it->span - it->off, n = MIN(left, len - done);
+		memcpy(buf + done, it->data, n);
+		done += n;
+		if(n < left) {
+			it->off += n;
+			it->data += n;
+			it->pos += n;
+		} else
+			st_iter_next_chunk(it); // off end if there isn't one
+	}
+	return done;
+}
+
+int st_iter_byte(const SliceIter *it)
+{
+	return iter_off_end(it) ? -1 : (unsigned char)it->data[0];
+}
+
+int st_iter_next_byte(SliceIter *it, size_t count)
+{
+	if(iter_off_end(it))
+		return -1;
+
+	size_t left = it->span - it->off;
+	if(count < left) {
+		it->off += count;
+		it->data += count;
+		it->pos += count;
+		return (unsigned char)*it->data;
+	} // cursor ends up off end if no next chunk
+	st_dbg("iter_next_byte: wanted %zd, had %zd\n", count, left);
+	st_iter_next_chunk(it);
+	return st_iter_next_byte(it, count - left);
+}
+
+int st_iter_prev_byte(SliceIter *it, size_t count)
+{
+	if(it->pos == 0)
+		return -1;
+
+	size_t left = it->off;
+	if(count <= left) {
+		it->off -= count;
+		it->data -= count;
+		it->pos -= count;
+		return (unsigned char)*it->data;
+	}
+	st_dbg("iter_prev_byte: wanted %zd, had %zd\n", count, left);
+	st_iter_prev_chunk(it); // lands on the byte before this chunk
+	return st_iter_prev_byte(it, count - left - 1);
+}
+
+// Assume utf-8
+// Assume that codepoints are not split across leaf boundaries
+// if this occurs, it means the user has already corrupted the file,
+// which should not be allowed. We never redistribute leaves, only merge
+long st_iter_cp(const SliceIter *it)
+{
+	static const int utf8_len[] = {
+		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+		0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0 // high bit set
+	};
+	static const int utf8_lead_masks[] = { 0, 0xFF, 0x1F, 0x0F, 0x07 };
+
+	if(iter_off_end(it)) // otherwise we always have at least one byte
+		return -1;
+	unsigned char lead = *it->data;
+
+	int len = utf8_len[lead >> 3];
+	const char *seq = it->data;
+	char buf[4];
+	if((unsigned)len > it->span - it->off) { // continued in the next slices
+		SliceIter rest = *it;
+		if(st_iter_read(&rest, len, buf) < (size_t)len)
+			return -1;
+		seq = buf;
+	}
+
+	long cp = lead & utf8_lead_masks[len];
+	for(int i = 1; i < len; i++)
+		cp = cp<<6 | (seq[i] & 0x3F);
+	return cp <= 0x10FFFF ? cp : -1;
+}
+
+// bytes counted by skip/rskip
+// UTF16 matches codepoints too, but those outside the BMP count twice
+enum byteclass { CP_LEAD, NEWLINE, UTF16, BRACKET };
+
+#ifdef __AVX2__
+static unsigned match32(__m256i v, enum byteclass cls)
+{
+	if(cls == BRACKET) { // folding { onto [, } onto ] and ) onto (
+		__m256i f = _mm256_and_si256(v, _mm256_set1_epi8(~0x20));
+		__m256i p = _mm256_and_si256(v, _mm256_set1_epi8(~1));
+		return _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(
+					_mm256_cmpeq_epi8(f, _mm256_set1_epi8('[')),
+					_mm256_cmpeq_epi8(f, _mm256_set1_epi8(']'))),
+					_mm256_cmpeq_epi8(p, _mm256_set1_epi8('('))));
+	}
+	// continuation bytes are 10xxxxxx, i.e. < -64 as signed chars
+	__m256i m = cls != NEWLINE ? _mm256_cmpgt_epi8(v, _mm256_set1_epi8(-65))
+								: _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n'));
+	return _mm256_movemask_epi8(m);
+}
+
+static size_t units32(__m256i v, enum byteclass cls)
+{
+	size_t n = __builtin_popcount(match32(v, cls));
+	// 4 byte sequences start with 11110xxx, i.e. >= -16 as signed chars
+	if(cls == UTF16)
+		n += __builtin_popcount(_mm256_movemask_epi8(v) & _mm256_movemask_epi8(
+								_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-17))));
+	return n;
+}
+#endif
+
+#ifdef __SSE2__
+static unsigned match16(__m128i v, enum byteclass cls)
+{
+	if(cls == BRACKET) {
+		__m128i f = _mm_and_si128(v, _mm_set1_epi8(~0x20));
+		__m128i p = _mm_and_si128(v, _mm_set1_epi8(~1));
+		return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(
+					_mm_cmpeq_epi8(f, _mm_set1_epi8('[')),
+					_mm_cmpeq_epi8(f, _mm_set1_epi8(']'))),
+					_mm_cmpeq_epi8(p, _mm_set1_epi8('('))));
+	}
+	__m128i m = cls != NEWLINE ? _mm_cmpgt_epi8(v, _mm_set1_epi8(-65))
+								: _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'));
+	return _mm_movemask_epi8(m);
+}
+
+static size_t units16(__m128i v, enum byteclass cls)
+{
+	size_t n = __builtin_popcount(match16(v, cls));
+	if(cls == UTF16)
+		n += __builtin_popcount(_mm_movemask_epi8(v) & _mm_movemask_epi8(
+								_mm_cmpgt_epi8(v, _mm_set1_epi8(-17))));
+	return n;
+}
+#endif
+
+// 1 + 2 * its class for (, [ and {, 2 + 2 * its class for their closers
+static int bracket(char c)
+{
+	switch(c) {
+		case '(': return 1;
+		case ')': return 2;
+		case '[': return 3;
+		case ']': return 4;
+		case '{': return 5;
+		case '}': return 6;
+	}
+	return 0;
+}
+
+static bool match(char c, enum byteclass cls)
+{
+	if(cls == BRACKET)
+		return bracket(c);
+	return cls != NEWLINE ? (c & 0xC0) != 0x80 : c == '\n';
+}
+
+static size_t units(char c, enum byteclass cls)
+{
+	return match(c, cls) + (cls == UTF16 && (unsigned char)c >= 0xF0);
+}
+
+// returns the offset of the count'th byte of class cls in p[0, n) or n if
+// there are fewer, subtracting those passed from *count. For UTF16, the
+// offset of the codepoint with the count'th unit
+static size_t skip(const char *p, size_t n, size_t *count, enum byteclass cls)
+{
+	size_t i = 0;
+#ifdef __AVX2__
+	for(; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+		size_t found = units32(v, cls);
+		if(found >= *count)
+			break;
+		*count -= found;
+	}
+#endif
+#ifdef __SSE2__
+	for(; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		size_t found = units16(v, cls);
+		if(found >= *count)
+			break;
+		*count -= found;
+	}
+#endif
+	for(; i < n; i++) {
+		size_t found = units(p[i], cls);
+		if(found && found >= *count) {
+			*count = 0;
+			return i;
+		}
+		*count -= found;
+	}
+	return n;
+}
+
+// as skip, but counting back from the end of p[0, n)
+static size_t rskip(const char *p, size_t n, size_t *count, enum byteclass cls)
+{
+	size_t i = n;
+#ifdef __AVX2__
+	for(; i >= 32; i -= 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(p + i - 32));
+		size_t found = units32(v, cls);
+		if(found >= *count)
+			break;
+		*count -= found;
+	}
+#endif
+#ifdef __SSE2__
+	for(; i >= 16; i -= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i - 16));
+		size_t found = units16(v, cls);
+		if(found >= *count)
+			break;
+		*count -= found;
+	}
+#endif
+	while(i-- > 0) {
+		size_t found = units(p[i], cls);
+		if(found && found >= *count) {
+			*count = 0;
+			return i;
+		}
+		*count -= found;
+	}
+	return n;
+}
+
+// moves forward to the count'th byte of class cls after the current one
+static bool iter_skip(SliceIter *it, size_t count, enum byteclass cls)
+{
+	if(iter_off_end(it))
+		return false;
+	// the current byte doesn't count, scan whole chunks after that
+	size_t from = it->off + 1;
+	for(;;) {
+		char *base = it->data - it->off;
+		size_t i = from + skip(base + from, it->span - from, &count, cls);
+		if(i < it->span) {
+			it->pos += i - it->off;
+			it->off = i;
+			it->data = base + i;
+			return true;
+		}
+		if(!st_iter_next_chunk(it))
+			return false;
+		from = 0;
+	}
+}
+
+// moves back to the count'th byte of class cls before the current one
+static bool iter_rskip(SliceIter *it, size_t count, enum byteclass cls)
+{
+	// bytes before the current one in this chunk, then whole chunks
+	size_t to = it->off;
+	for(;;) {
+		char *base = it->data - it->off;
+		size_t i = rskip(base, to, &count, cls);
+		if(i < to) {
+			it->pos -= it->off - i;
+			it->off = i;
+			it->data = base + i;
+			return true;
+		}
+		if(!st_iter_prev_chunk(it))
+			return false;
+		to = it->span;
+	}
+}
+
+long st_iter_next_cp(SliceIter *it, size_t count)
+{
+	if(count > 0 && !iter_skip(it, count, CP_LEAD))
+		return -1;
+	return st_iter_cp(it);
+}
+
+long st_iter_prev_cp(SliceIter *it, size_t count)
+{
+	if(count > 0 && !iter_rskip(it, count, CP_LEAD))
+		return -1;
+	return st_iter_cp(it);
+}
+
+// go forwards count newlines, step forward once
+bool st_iter_next_line(SliceIter *it, size_t count)
+{
+	// a newline under the cursor is the first
+	if(count > 0 && st_iter_byte(it) == '\n')
+		count--;
+	if(count > 0 && !iter_skip(it, count, NEWLINE))
+		return false;
+	st_iter_next_byte(it, 1); // it's ok if it's off end
+	return true;
+}
+
+// go backwards count+1 newlines, step forward once
+bool st_iter_prev_line(SliceIter *it, size_t count)
+{
+	if(!iter_rskip(it, count + 1, NEWLINE))
+		return false;
+	st_iter_next_byte(it, 1);
+	return true;
+}
+
+/* columns */
+
+// wide[] and zero[] are in graphemes.h
+
+static bool in_ranges(const struct cprange *r, int n, long cp)
+{
+	int lo = 0, hi = n;
+	while(lo < hi) {
+		int mid = (lo + hi) / 2;
+		if(cp > r[mid].to)
+			lo = mid + 1;
+		else if(cp < r[mid].from)
+			hi = mid;
+		else
+			return true;
+	}
+	return false;
+}
+
+// the columns taken at col by cp, 1 if it's malformed (-1)
+static size_t cp_width(long cp, size_t col, int tabwidth)
+{
+	if(cp == '\t')
+		return tabwidth - col % tabwidth;
+	else if(cp < 0x300)
+		return 1;
+	else if(in_ranges(zero, sizeof zero / sizeof *zero, cp))
+		return 0;
+	return in_ranges(wide, sizeof wide / sizeof *wide, cp) ? 2 : 1;
+}
+
+// the length of the UTF-8 sequence a byte leads, 0 for continuation bytes
+static size_t lead_len(unsigned char c)
+{
+	return c < 0x80 ? 1 : c < 0xC0 ? 0 : c < 0xE0 ? 2 : c < 0xF0 ? 3 : 4;
+}
+
+// the columns taken at col by the codepoint starting p[0, n), 0 if it's a
+// continuation byte. Tabs reach the next multiple of tabwidth
+static size_t width(const char *p, size_t n, size_t col, int tabwidth)
+{
+	unsigned char c = *p;
+	if(c < 0xCC) // below U+0300 or continuing
+		return c == '\t' ? tabwidth - col % tabwidth : (c & 0xC0) != 0x80;
+	size_t len = MIN(lead_len(c), n);
+	long cp = c & (0x7F >> len);
+	for(size_t i = 1; i < len; i++)
+		cp = cp<<6 | (p[i] & 0x3F);
+	return cp_width(cp <= 0x10FFFF ? cp : -1, col, tabwidth);
+}
+
+// bytes whose columns depend on more than themselves: tabs, newlines (to
+// stop at) and leads of codepoints from U+0300, which may be wide or take
+// none
+#ifdef __AVX2__
+static unsigned special32(__m256i v)
+{
+	__m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')),
+								_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')));
+	return _mm256_movemask_epi8(m) | (_mm256_movemask_epi8(v) &
+			_mm256_movemask_epi8(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-53))));
+}
+#endif
+
+#ifdef __SSE2__
+static unsigned special16(__m128i v)
+{
+	__m128i m = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+							_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+	return _mm_movemask_epi8(m) | (_mm_movemask_epi8(v) &
+			_mm_movemask_epi8(_mm_cmpgt_epi8(v, _mm_set1_epi8(-53))));
+}
+#endif
+
+// as columns over p[i, end) of p[0, n)
+static size_t columns_scalar(const char *p, size_t i, size_t end, size_t n,
+							size_t *col, size_t target, int tabwidth)
+{
+	for(; i < end; i++) {
+		if(p[i] == '\n' || lead_len(p[i]) > n - i)
+			return i;
+		size_t w = width(p + i, n - i, *col, tabwidth);
+		if(w && *col + w > target)
+			return i;
+		*col += w;
+	}
+	return end;
+}
+
+// as columns over the vector p[i, i+len) given its masks of codepoint leads
+// and special bytes. The runs in between count a column per lead
+static size_t columns_vector(const char *p, size_t i, int len, uint64_t leads,
+							uint64_t special, size_t n, size_t *col,
+							size_t target, int tabwidth)
+{
+	int from = 0;
+	for(;;) {
+		int k = special ? __builtin_ctzll(special) : len;
+		uint64_t run = leads & (((uint64_t)1 << k) - 1);
+		size_t count = __builtin_popcountll(run);
+		if(*col + count > target)
+			return columns_scalar(p, i + from, i + len, n, col, target,
+								tabwidth);
+		*col += count;
+		if(k == len)
+			return i + len;
+		size_t stop = columns_scalar(p, i + k, i + k + 1, n, col, target,
+									tabwidth);
+		if(stop == i + k)
+			return stop;
+		leads &= ~(((uint64_t)2 << k) - 1);
+		special &= special - 1;
+		from = k + 1;
+	}
+}
+
+// advances *col over p[0, n) up to a newline, the codepoint taking up column
+// target or one cut off by the end, returning its offset or n
+static size_t columns(const char *p, size_t n, size_t *col, size_t target,
+						int tabwidth)
+{
+	size_t i = 0, stop;
+#ifdef __AVX2__
+	for(; i + 32 <= n; i += 32) {
+		__m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+		if((stop = columns_vector(p, i, 32, match32(v, CP_LEAD), special32(v),
+								n, col, target, tabwidth)) < i + 32)
+			return stop;
+	}
+#endif
+#ifdef __SSE2__
+	for(; i + 16 <= n; i += 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		if((stop = columns_vector(p, i, 16, match16(v, CP_LEAD), special16(v),
+								n, col, target, tabwidth)) < i + 16)
+			return stop;
+	}
+#endif
+	return columns_scalar(p, i, n, n, col, target, tabwidth);
+}
+
+// to the start of its line
+static void iter_line_start(SliceIter *it)
+{
+	if(iter_rskip(it, 1, NEWLINE))
+		st_iter_next_byte(it, 1);
+}
+
+size_t st_iter_visual_col(const SliceIter *it, int tabwidth)
+{
+	SliceIter line = *it;
+	iter_line_start(&line);
+	size_t col = 0;
+	while(line.pos < it->pos) {
+		size_t len = MIN(line.span - line.off, it->pos - line.pos);
+		size_t off = columns(line.data, len, &col, SIZE_MAX, tabwidth);
+		if(off < len) { // a codepoint continuing in the next chunk
+			st_iter_next_byte(&line, off);
+			col += cp_width(st_iter_cp(&line), col, tabwidth);
+			st_iter_next_cp(&line, 1);
+		} else if(!st_iter_next_chunk(&line))
+			break;
+	}
+	return col;
+}
+
+size_t st_iter_to_visual_col(SliceIter *it, size_t col, int tabwidth)
+{
+	iter_line_start(it);
+	size_t at = 0;
+	for(;;) {
+		size_t len = it->span - it->off;
+		size_t off = columns(it->data, len, &at, col, tabwidth);
+		if(off == len) {
+			if(!st_iter_next_chunk(it))
+				break;
+			continue;
+		}
+		it->off += off;
+		it->data += off;
+		it->pos += off;
+		if(*it->data == '\n' || lead_len(*it->data) <= len - off)
+			break;
+		// it continues in the next chunk
+		size_t w = cp_width(st_iter_cp(it), at, tabwidth);
+		if(w && at + w > col)
+			break;
+		at += w;
+		st_iter_next_cp(it, 1);
+	}
+	return at;
+}
+
+/* graphemes */
+
+static enum gcb gcb_of(long cp)
+{
+	if(cp < 0) // malformed
+		return GCB_OTHER;
+	int lo = 0, hi = sizeof gcb_ranges / sizeof *gcb_ranges;
+	while(hi - lo > 1) {
+		int mid = (lo + hi) / 2;
+		if(gcb_ranges[mid] >> 8 <= (unsigned long)cp)
+			lo = mid;
+		else
+			hi = mid;
+	}
+	enum gcb prop = gcb_ranges[lo] & 0xFF;
+	if(prop == GCB_LV && (cp - 0xAC00) % 28) // the table merges syllables
+		prop = GCB_LVT;
+	return prop;
+}
+
+// whether a and b are in one cluster. zwj: a is a ZWJ after an emoji and
+// extending characters (GB11). odd: an odd number of regional indicators
+// runs up to a (GB12, GB13)
+static bool gcb_joins(enum gcb a, enum gcb b, bool zwj, bool odd)
+{
+	if(a == GCB_CR)
+		return b == GCB_LF;
+	else if(a == GCB_LF || a == GCB_CONTROL ||
+			b == GCB_CR || b == GCB_LF || b == GCB_CONTROL)
+		return false;
+	else if(a == GCB_L && (b == GCB_L || b == GCB_V || b == GCB_LV ||
+							b == GCB_LVT) ||
+			(a == GCB_LV || a == GCB_V) && (b == GCB_V || b == GCB_T) ||
+			(a == GCB_LVT || a == GCB_T) && b == GCB_T)
+		return true;
+	else if(b == GCB_EXTEND || b == GCB_ZWJ || b == GCB_SPACINGMARK ||
+			a == GCB_PREPEND)
+		return true;
+	else if(a == GCB_ZWJ && b == GCB_PICTO)
+		return zwj;
+	else if(a == GCB_RI && b == GCB_RI)
+		return odd;
+	return false;
+}
+
+// moves past the cluster starting at the iterator
+static bool iter_next_cluster(SliceIter *it)
+{
+	if(iter_off_end(it))
+		return false;
+	enum gcb a = gcb_of(st_iter_cp(it)), b;
+	// emoji: 1 after an emoji and extending characters, 2 after a ZWJ too
+	int emoji = a == GCB_PICTO;
+	size_t ri = a == GCB_RI;
+	for(;; a = b) {
+		long cp = st_iter_next_cp(it, 1);
+		if(iter_off_end(it))
+			return true;
+		b = gcb_of(cp);
+		if(!gcb_joins(a, b, emoji == 2, ri % 2))
+			return true;
+		emoji = b == GCB_PICTO || emoji == 1 && b == GCB_EXTEND ? 1 :
+				emoji == 1 && b == GCB_ZWJ ? 2 : 0;
+		ri = b == GCB_RI ? ri + 1 : 0;
+	}
+}
+
+// whether the ZWJ the iterator is at follows an emoji and extending ones
+static bool zwj_after_emoji(SliceIter it)
+{
+	enum gcb prop;
+	do {
+		if(it.pos == 0)
+			return false;
+		prop = gcb_of(st_iter_prev_cp(&it, 1));
+	} while(prop == GCB_EXTEND);
+	return prop == GCB_PICTO;
+}
+
+// whether an odd number of regional indicators run up to the iterator's
+static bool ri_odd(SliceIter it)
+{
+	size_t n = 1;
+	while(it.pos > 0 && gcb_of(st_iter_prev_cp(&it, 1)) == GCB_RI)
+		n++;
+	return n % 2;
+}
+
+// moves to the start of the cluster ending at the iterator
+static bool iter_prev_cluster(SliceIter *it)
+{
+	if(it->pos == 0)
+		return false;
+	enum gcb b = gcb_of(st_iter_prev_cp(it, 1));
+	while(it->pos > 0) {
+		SliceIter before = *it;
+		enum gcb a = gcb_of(st_iter_prev_cp(&before, 1));
+		if(!gcb_joins(a, b, a == GCB_ZWJ && b == GCB_PICTO &&
+							zwj_after_emoji(before),
+						a == GCB_RI && b == GCB_RI && ri_odd(before)))
+			break;
+		*it = before;
+		b = a;
+	}
+	return true;
+}
+
+// an ASCII character followed by another is a cluster, unless it's CR LF,
+// so runs of ASCII are stepped a byte at a time like st_iter_next_byte
+bool st_iter_next_grapheme(SliceIter *it, size_t count)
+{
+	for(; count > 0; count--) {
+		if(it->off + 1 < it->span) {
+			unsigned char c = it->data[0], next = it->data[1];
+			if(c < 0x80 && next < 0x80 && (c != '\r' || next != '\n')) {
+				it->off++;
+				it->data++;
+				it->pos++;
+				continue;
+			}
+		}
+		if(!iter_next_cluster(it))
+			return false;
+	}
+	return true;
+}
+
+bool st_iter_prev_grapheme(SliceIter *it, size_t count)
+{
+	for(; count > 0; count--) {
+		if(it->off >= 2) {
+			unsigned char c = it->data[-1], before = it->data[-2];
+			if(c < 0x80 && before < 0x80 && (before != '\r' || c != '\n')) {
+				it->off--;
+				it->data--;
+				it->pos--;
+				continue;
+			}
+		}
+		if(!iter_prev_cluster(it))
+			return false;
+	}
+	return true;
+}
+
+/* metrics */
+
+static size_t count_units(const char *p, size_t n, enum byteclass cls)
+{
+	size_t left = SIZE_MAX;
+	skip(p, n, &left, cls);
+	return SIZE_MAX - left;
+}
+
+static size_t count_newlines(const char *p, size_t n)
+{
+	return count_units(p, n, NEWLINE);
+}
+
+static void measure_newlines(size_t *sum, const char *data, size_t len)
+{
+	*sum = count_newlines(data, len);
+}
+
+static size_t seek_newlines(const char *data, size_t len, size_t *count)
+{
+	return skip(data, len, count, NEWLINE);
+}
+
+const StMetric st_newlines = {
+	.fields = 1, .measure = measure_newlines, .seek = seek_newlines
+};
+
+static void measure_codepoints(size_t *sum, const char *data, size_t len)
+{
+	*sum = count_units(data, len, CP_LEAD);
+}
+
+static size_t seek_codepoints(const char *data, size_t len, size_t *count)
+{
+	return skip(data, len, count, CP_LEAD);
+}
+
+const StMetric st_codepoints = {
+	.fields = 1, .measure = measure_codepoints, .seek = seek_codepoints
+};
+
+static void measure_utf16(size_t *sum, const char *data, size_t len)
+{
+	*sum = count_units(data, len, UTF16);
+}
+
+static size_t seek_utf16(const char *data, size_t len, size_t *count)
+{
+	return skip(data, len, count, UTF16);
+}
+
+const StMetric st_utf16 = {
+	.fields = 1, .measure = measure_utf16, .seek = seek_utf16
+};
+
+static void measure_line_lengths(size_t *sum, const char *data, size_t len)
+{
+	const char *end = data + len, *nl = memchr(data, '\n', len), *next;
+	sum[0] = sum[3] = 0;
+	sum[1] = sum[2] = nl ? (size_t)(nl - data) : len;
+	if(!nl)
+		return;
+	for(; (next = memchr(nl + 1, '\n', end - nl - 1)); nl = next, sum[0]++)
+		sum[3] = MAX(sum[3], (size_t)(next - nl - 1));
+	sum[0]++;
+	sum[2] = end - nl - 1;
+}
+
+static void combine_line_lengths(size_t *sum, const size_t *next)
+{
+	if(next[0] == 0) { // it continues our last line
+		sum[2] += next[2];
+		if(sum[0] == 0)
+			sum[1] = sum[2];
+		return;
+	}
+	if(sum[0] == 0) {
+		sum[1] += next[1];
+		sum[3] = next[3];
+	} else
+		sum[3] = MAX(MAX(sum[3], next[3]), sum[2] + next[1]);
+	sum[2] = next[2];
+	sum[0] += next[0];
+}
+
+const StMetric st_line_lengths = {
+	.fields = 4, .measure = measure_line_lengths,
+	.combine = combine_line_lengths, .seek = seek_newlines
+};
+
+static void measure_brackets(size_t *sum, const char *data, size_t len)
+{
+	size_t i = 0, one = 1;
+	memset(sum, 0, 6 * sizeof(size_t));
+	while((i += skip(data + i, len - i, &one, BRACKET)) < len) {
+		int b = bracket(data[i++]) - 1;
+		size_t *s = &sum[b & ~1];
+		if(!(b & 1))
+			s[1]++;
+		else if(s[1])
+			s[1]--;
+		else
+			s[0]++;
+		one = 1;
+	}
+}
+
+static void combine_brackets(size_t *sum, const size_t *next)
+{
+	for(int k = 0; k < 6; k += 2) {
+		size_t matched = MIN(sum[k + 1], next[k]);
+		sum[k] += next[k] - matched;
+		sum[k + 1] += next[k + 1] - matched;
+	}
+}
+
+const StMetric st_brackets = {
+	.fields = 6, .measure = measure_brackets, .combine = combine_brackets
+};
+
+static void combine(const StMetric *m, size_t *sum, const size_t *next)
+{
+	if(m->combine)
+		m->combine(sum, next);
+	else
+		for(int f = 0; f < m->fields; f++)
+			sum[f] += next[f];
+}
+
+// the chunk summaries of m for b, added if it has none yet
+static struct chunksums *block_chunks(struct block *b, const StMetric *m)
+{
+	struct chunksums *head = atomic_load_explicit(&b->chunks,
+												memory_order_acquire);
+	struct chunksums *new = NULL;
+	while(true) {
+		for(struct chunksums *c = head; c; c = c->next)
+			if(c->m == m) {
+				free(new);
+				return c;
+			}
+		if(!new) {
+			// zeroed lazily by the kernel, so unmeasured chunks cost nothing
+			new = calloc(1, sizeof *new +
+						(b->len / CHUNK + 1) * m->fields * sizeof(size_t));
+			if(!new)
+				return NULL;
+			new->m = m;
+		}
+		new->next = head;
+		if(atomic_compare_exchange_weak_explicit(&b->chunks, &head, new,
+					memory_order_acq_rel, memory_order_acquire))
+			return new;
+	}
+}
+
+// summarizes the k'th CHUNK of b, measuring it only the first time
+static void chunk_sum(const struct block *b, struct chunksums *c, size_t k,
+						size_t *sum)
+{
+	int last = c->m->fields - 1;
+	atomic_size_t *s = &c->data[k * c->m->fields];
+	size_t known = atomic_load_explicit(&s[last], memory_order_acquire);
+	if(known) {
+		for(int f = 0; f < last; f++)
+			sum[f] = atomic_load_explicit(&s[f], memory_order_relaxed);
+		sum[last] = known - 1;
+		return;
+	}
+	size_t off = k * CHUNK;
+	c->m->measure(sum, b->data + off, MIN(CHUNK, b->len - off));
+	for(int f = 0; f < last; f++)
+		atomic_store_explicit(&s[f], sum[f], memory_order_relaxed);
+	atomic_store_explicit(&s[last], sum[last] + 1, memory_order_release);
+}
+
+// as m->measure, combining the summaries of whole chunks of large blocks
+static void measure(const SliceTable *st, const StMetric *m, size_t *sum,
+					const char *p, size_t n)
+{
+	struct block *b = n >= CHUNK ? slice_block(st, p) : NULL;
+	struct chunksums *c = b ? block_chunks(b, m) : NULL;
+	if(!c) {
+		m->measure(sum, p, n);
+		return;
+	}
+	size_t first = (p - b->data + CHUNK-1) / CHUNK;
+	size_t last = (p + n - b->data) / CHUNK;
+	const char *from = b->data + first * CHUNK;
+	const char *to = b->data + last * CHUNK;
+	size_t part[ST_METRIC_FIELDS];
+	m->measure(sum, p, from - p);
+	for(size_t k = first; k < last; k++) {
+		chunk_sum(b, c, k, part);
+		combine(m, sum, part);
+	}
+	m->measure(part, to, p + n - to);
+	combine(m, sum, part);
+}
+
+// the summaries of st's metrics for node, if it has them
+static const struct sums *node_sums(const SliceTable *st,
+									const struct node *node)
+{
+	const struct sums *s = atomic_load_explicit(&node->sums,
+												memory_order_acquire);
+	while(s && s->set != st->metrics->id)
+		s = s->next;
+	return s;
+}
+
+// summarizes a leaf's slots, reusing what it can from its old summaries
+static void sums_leaf(const SliceTable *st, const struct node *leaf, int fill,
+						struct sums *s)
+{
+	const struct metricset *set = st->metrics;
+	size_t data[B * set->stride];
+	for(int i = 0; i < fill; i++) {
+		const char *p = leaf->child[i];
+		size_t span = leaf->spans[i];
+		size_t *sum = &data[i * set->stride];
+		int j = B;
+		// a large slice within one summarized before needs only the
+		// difference measured for counts, e.g. after a split the smaller side
+		if(span > HIGH_WATER)
+			for(j = 0; j < B; j++)
+				if(s->child[j] && s->spans[j] > HIGH_WATER &&
+						p >= (char *)s->child[j] &&
+						p + span <= (char *)s->child[j] + s->spans[j])
+					break;
+		const char *from = j < B ? s->child[j] : p;
+		size_t before = p - from, after = j < B ? s->spans[j] - before - span
+												: 0;
+		for(int k = 0; k < set->n; k++) {
+			const StMetric *m = set->m[k];
+			size_t *msum = sum + set->off[k];
+			const size_t *old = &s->data[j * set->stride + set->off[k]];
+			if(j < B && before + after == 0)
+				memcpy(msum, old, m->fields * sizeof(size_t));
+			else if(j < B && !m->combine && before + after < span) {
+				size_t head[ST_METRIC_FIELDS], tail[ST_METRIC_FIELDS];
+				measure(st, m, head, from, before);
+				measure(st, m, tail, p + span, after);
+				for(int f = 0; f < m->fields; f++)
+					msum[f] = old[f] - head[f] - tail[f];
+			} else
+				measure(st, m, msum, p, span);
+		}
+	}
+	memcpy(s->data, data, fill * set->stride * sizeof(size_t));
+	memcpy(s->child, leaf->child, sizeof s->child);
+	memcpy(s->spans, leaf->spans, sizeof s->spans);
+}
+
+// summarizes nodes edited or without summaries of st's metrics, which all
+// lie on paths from the root, returning the node's summary
+static const size_t *sums_update(const SliceTable *st, struct node *node,
+								int level)
+{
+	const struct metricset *set = st->metrics;
+	struct sums *head = atomic_load_explicit(&node->sums, memory_order_acquire);
+	struct sums *s = head;
+	while(s && s->set != set->id)
+		s = s->next;
+	if(s && !s->stale)
+		return &s->data[B * set->stride];
+	if(s) { // edited by us just now, so ours alone: drop other sets'
+		for(struct sums *o = head, *next; o; o = next) {
+			next = o->next;
+			if(o != s)
+				free(o);
+		}
+		s->next = NULL;
+		atomic_store_explicit(&node->sums, s, memory_order_relaxed);
+	}
+	bool publish = !s;
+	if(publish) {
+		size_t size = sizeof *s + (B+1) * set->stride * sizeof(size_t);
+		s = malloc(size);
+		s->set = set->id;
+		s->size = size;
+		memset(s->child, 0, sizeof s->child);
+	}
+	int fill = node_fill(node, 0);
+	if(level == 1)
+		sums_leaf(st, node, fill, s);
+	else
+		for(int i = 0; i < fill; i++)
+			memcpy(&s->data[i * set->stride],
+					sums_update(st, node->child[i], level - 1),
+					set->stride * sizeof(size_t));
+	size_t *total = &s->data[B * set->stride];
+	for(int k = 0; k < set->n; k++) {
+		measure(st, set->m[k], total + set->off[k], "", 0);
+		for(int i = 0; i < fill; i++)
+			combine(set->m[k], total + set->off[k],
+					&s->data[i * set->stride + set->off[k]]);
+	}
+	s->stale = false;
+	// other tables may be reading the node
+	if(publish) {
+		s->next = atomic_load_explicit(&node->sums, memory_order_relaxed);
+		while(!atomic_compare_exchange_weak_explicit(&node->sums, &s->next, s,
+						memory_order_release, memory_order_relaxed))
+			;
+	}
+	return total;
+}
+
+// drops the summaries of nodes only st can reach
+static void sums_drop(struct node *node, int level)
+{
+	if(atomic_load_explicit(&node->refc, memory_order_acquire) != 1)
+		return;
+	free_sums(atomic_load_explicit(&node->sums, memory_order_relaxed));
+	atomic_store_explicit(&node->sums, NULL, memory_order_relaxed);
+	for(int i = 0; level > 1 && i < B && node->child[i]; i++)
+		sums_drop(node->child[i], level - 1);
+}
+
+int st_add_metric(SliceTable *st, const StMetric *metric)
+{
+	static atomic_ulong ids = 1;
+	int n = st->metrics ? st->metrics->n : 0;
+	int stride = st->metrics ? st->metrics->stride : 0;
+	if(n == ST_MAX_METRICS || metric->fields < 1 ||
+			metric->fields > ST_METRIC_FIELDS)
+		return -1;
+	struct metricset *set = malloc(sizeof *set);
+	if(!set)
+		return -1;
+	if(st->metrics)
+		*set = *st->metrics;
+	set->id = atomic_fetch_add_explicit(&ids, 1, memory_order_relaxed);
+	set->m[n] = metric;
+	set->off[n] = stride;
+	set->stride = stride + metric->fields;
+	set->n = n + 1;
+	free(st->metrics);
+	st->metrics = set;
+	sums_drop(st->root, st->levels);
+	sums_update(st, st->root, st->levels);
+	return n;
+}
+
+// combines into sum the summary of [from, to) of the subtree
+static void summarize(const SliceTable *st, int k, const struct node *node,
+						int level, size_t from, size_t to, size_t *sum)
+{
+	const struct metricset *set = st->metrics;
+	const struct sums *s = node_sums(st, node);
+	size_t start = 0;
+	for(int i = 0; i < B && node->child[i] && start < to; i++) {
+		size_t end = start + node->spans[i];
+		if(end > from) {
+			if(from <= start && end <= to)
+				combine(set->m[k], sum, &s->data[i*set->stride + set->off[k]]);
+			else if(level > 1)
+				summarize(st, k, node->child[i], level - 1,
+						MAX(from, start) - start, MIN(to, end) - start, sum);
+			else {
+				size_t part[ST_METRIC_FIELDS];
+				size_t lo = MAX(from, start) - start;
+				measure(st, set->m[k], part, (char *)node->child[i] + lo,
+						MIN(to, end) - start - lo);
+				combine(set->m[k], sum, part);
+			}
+		}
+		start = end;
+	}
+}
+
+void st_summarize(const SliceTable *st, int metric, size_t from, size_t to,
+					size_t *sum)
+{
+	measure(st, st->metrics->m[metric], sum, "", 0);
+	if(from < to)
+		summarize(st, metric, st->root, st->levels, from, to, sum);
+}
+
+// as m->seek, passing whole chunks of large blocks by their summaries
+static size_t seek(const SliceTable *st, const StMetric *m, const char *p,
+					size_t n, size_t *count)
+{
+	struct block *b = n >= CHUNK ? slice_block(st, p) : NULL;
+	struct chunksums *c = b ? block_chunks(b, m) : NULL;
+	if(!c)
+		return m->seek(p, n, count);
+	size_t k = (p - b->data + CHUNK-1) / CHUNK;
+	size_t last = (p + n - b->data) / CHUNK;
+	size_t off = b->data + k * CHUNK - p;
+	size_t found = m->seek(p, off, count);
+	if(found < off)
+		return found;
+	size_t sum[ST_METRIC_FIELDS];
+	for(; k < last; k++, off += CHUNK) {
+		chunk_sum(b, c, k, sum);
+		if(sum[0] >= *count)
+			break;
+		*count -= sum[0];
+	}
+	return off + m->seek(p + off, n - off, count);
+}
+
+size_t st_metric_seek(const SliceTable *st, int metric, size_t count)
+{
+	const struct metricset *set = st->metrics;
+	const struct node *node = st->root;
+	int field = set->off[metric]; // field 0 of the metric
+	if(count == 0)
+		return 0;
+	if(count > node_sums(st, node)->data[B * set->stride + field])
+		return st_size(st);
+	// find the slice with the count'th unit
+	size_t pos = 0;
+	for(int level = st->levels; ; level--) {
+		const struct sums *s = node_sums(st, node);
+		int i = 0;
+		while(s->data[i * set->stride + field] < count) {
+			count -= s->data[i * set->stride + field];
+			pos += node->spans[i++];
+		}
+		if(level == 1)
+			return pos + seek(st, set->m[metric], node->child[i],
+								node->spans[i], &count);
+		node = node->child[i];
+	}
+}
+
+/* positions */
+
+static int metric_index(const SliceTable *st, const StMetric *m)
+{
+	for(int k = 0; st->metrics && k < st->metrics->n; k++)
+		if(st->metrics->m[k] == m)
+			return k;
+	return -1;
+}
+
+// m's summary of [from, to), scanning it if st doesn't keep m
+static void metric_summarize(const SliceTable *st, const StMetric *m,
+							size_t from, size_t to, size_t *sum)
+{
+	size_t part[ST_METRIC_FIELDS];
+	to = MIN(to, st_size(st));
+	measure(st, m, sum, "", 0);
+	if(from >= to)
+		return;
+	int k = metric_index(st, m);
+	if(k >= 0) {
+		st_summarize(st, k, from, to, sum);
+		return;
+	}
+	SliceIter it;
+	st_iter_init(&it, (SliceTable *)st, from);
+	do {
+		size_t len = MIN(it.span - it.off, to - it.pos);
+		measure(st, m, part, it.data, len);
+		combine(m, sum, part);
+	} while(it.pos + it.span - it.off < to && st_iter_next_chunk(&it));
+}
+
+// field 0 of m's summary of [from, to)
+static size_t metric_count(const SliceTable *st, const StMetric *m,
+							size_t from, size_t to)
+{
+	size_t sum[ST_METRIC_FIELDS];
+	metric_summarize(st, m, from, to, sum);
+	return sum[0];
+}
+
+// the offset of the count'th unit of m from from, or st_size if there are
+// fewer. Slices st keeps m for are skipped by their summaries
+static size_t metric_seek(const SliceTable *st, const StMetric *m,
+							size_t from, size_t count)
+{
+	int k = metric_index(st, m);
+	if(k >= 0 && from == 0)
+		return st_metric_seek(st, k, count);
+	if(count == 0 || from >= st_size(st))
+		return MIN(from, st_size(st));
+	SliceIter it;
+	st_iter_init(&it, (SliceTable *)st, from);
+	do {
+		size_t len = it.span - it.off;
+		const struct sums *s = k >= 0 && it.off == 0 ? node_sums(st, it.leaf)
+														: NULL;
+		if(s) {
+			const struct metricset *set = st->metrics;
+			size_t units = s->data[it.node_offset*set->stride + set->off[k]];
+			if(units < count) {
+				count -= units;
+				continue;
+			}
+		}
+		size_t off = seek(st, m, it.data, len, &count);
+		if(off < len)
+			return it.pos + off;
+	} while(st_iter_next_chunk(&it));
+	return st_size(st);
+}
+
+void st_enable_lines(SliceTable *st)
+{
+	if(metric_index(st, &st_newlines) < 0)
+		st_add_metric(st, &st_newlines);
+}
+
+size_t st_line_to_pos(const SliceTable *st, size_t line)
+{
+	if(line == 0)
+		return 0;
+	size_t pos = metric_seek(st, &st_newlines, 0, line);
+	return pos < st_size(st) ? pos + 1 : pos;
+}
+
+size_t st_pos_to_line(const SliceTable *st, size_t pos)
+{
+	return metric_count(st, &st_newlines, 0, pos);
+}
+
+size_t st_pos_to_cp(const SliceTable *st, size_t from, size_t pos)
+{
+	return metric_count(st, &st_codepoints, from, pos);
+}
+
+size_t st_cp_to_pos(const SliceTable *st, size_t from, size_t cp)
+{
+	return metric_seek(st, &st_codepoints, from, cp + 1);
+}
+
+size_t st_pos_to_utf16(const SliceTable *st, size_t from, size_t pos)
+{
+	return metric_count(st, &st_utf16, from, pos);
+}
+
+size_t st_utf16_to_pos(const SliceTable *st, size_t from, size_t unit)
+{
+	return metric_seek(st, &st_utf16, from, unit + 1);
+}
+
+size_t st_longest_line(const SliceTable *st, size_t from, size_t to)
+{
+	size_t sum[ST_METRIC_FIELDS];
+	metric_summarize(st, &st_line_lengths, from, to, sum);
+	return MAX(MAX(sum[1], sum[2]), sum[3]);
+}
+
+/* brackets */
+
+// summaries of st_brackets are, per class, closers without openers before
+// them and openers without closers after them. Searching forwards, a match of
+// class k is the need[k]'th closer without an opener after the start, and
+// backwards the need[k]'th opener without a closer before the end. Classes
+// with need[k] == 0 aren't searched for, so the text inside a pair needn't be
+// balanced in them. On a match, need[k] becomes 0 for its class
+
+// passes a summary, unless it holds a match
+static bool pass_brackets(const size_t *sum, bool back, size_t *need)
+{
+	for(int k = 0; k < 3; k++)
+		if(need[k] && sum[2 * k + back] >= need[k])
+			return false;
+	for(int k = 0; k < 3; k++)
+		if(need[k])
+			need[k] = need[k] - sum[2 * k + back] + sum[2 * k + !back];
+	return true;
+}
+
+// the offset of the first match in p[0, n) or n
+static size_t scan_brackets(const char *p, size_t n, bool back, size_t *need)
+{
+	size_t i = back ? n : 0, one = 1;
+	for(;;) {
+		size_t j = back ? rskip(p, i, &one, BRACKET)
+						: i + skip(p + i, n - i, &one, BRACKET);
+		if(j == (back ? i : n))
+			return n;
+		int b = bracket(p[j]) - 1, k = b >> 1;
+		if(need[k] && (b & 1) == back)
+			need[k]++;
+		else if(need[k] && --need[k] == 0)
+			return j;
+		i = back ? j : j + 1;
+		one = 1;
+	}
+}
+
+// as scan_brackets, passing whole chunks of file mappings by their summaries
+static size_t find_brackets(const SliceTable *st, const char *p, size_t n,
+							bool back, size_t *need)
+{
+	struct block *b = n >= CHUNK ? slice_block(st, p) : NULL;
+	struct chunksums *chunks = b ? block_chunks(b, &st_brackets) : NULL;
+	if(!chunks)
+		return scan_brackets(p, n, back, need);
+	size_t first = (p - b->data + CHUNK-1) / CHUNK;
+	size_t last = (p + n - b->data) / CHUNK;
+	size_t from = b->data + first * CHUNK - p;
+	size_t to = b->data + last * CHUNK - p;
+	size_t sum[6], found;
+	// the partial chunk we start in, whole ones up to the match, then it
+	if(!back) {
+		if((found = scan_brackets(p, from, back, need)) < from)
+			return found;
+		for(size_t c = first; c < last; c++, from += CHUNK) {
+			chunk_sum(b, chunks, c, sum);
+			if(!pass_brackets(sum, back, need))
+				break;
+		}
+		return from + scan_brackets(p + from, n - from, back, need);
+	}
+	if((found = scan_brackets(p + to, n - to, back, need)) < n - to)
+		return to + found;
+	for(size_t c = last; c-- > first; to -= CHUNK) {
+		chunk_sum(b, chunks, c, sum);
+		if(!pass_brackets(sum, back, need))
+			break;
+	}
+	found = scan_brackets(p, to, back, need);
+	return found < to ? found : n;
+}
+
+// the offset of the first match in [from, to) of the subtree or SIZE_MAX.
+// Children are passed by their summaries if st keeps st_brackets as metric m,
+// and scanned otherwise
+static size_t match_bracket(const SliceTable *st, int m,
+							const struct node *node, int level, size_t from,
+							size_t to, bool back, size_t *need)
+{
+	const struct metricset *set = st->metrics;
+	const struct sums *s = m >= 0 ? node_sums(st, node) : NULL;
+	int fill = node_fill(node, 0);
+	size_t start[B + 1] = {0};
+	for(int i = 0; i < fill; i++)
+		start[i + 1] = start[i] + node->spans[i];
+	for(int j = 0; j < fill; j++) {
+		int i = back ? fill - 1 - j : j;
+		size_t lo = MAX(from, start[i]), hi = MIN(to, start[i + 1]);
+		if(lo >= hi)
+			continue;
+		if(s && lo == start[i] && hi == start[i + 1] && pass_brackets(
+					&s->data[i * set->stride + set->off[m]], back, need))
+			continue;
+		size_t found;
+		if(level > 1)
+			found = match_bracket(st, m, node->child[i], level - 1,
+								lo - start[i], hi - start[i], back, need);
+		else {
+			found = find_brackets(st, (char *)node->child[i] + lo - start[i],
+								hi - lo, back, need);
+			found = found < hi - lo ? found + lo - start[i] : SIZE_MAX;
+		}
+		if(found != SIZE_MAX)
+			return start[i] + found;
+	}
+	return SIZE_MAX;
+}
+
+size_t st_match_bracket(const SliceTable *st, size_t pos)
+{
+	if(pos >= st_size(st))
+		return SIZE_MAX;
+	SliceIter it;
+	st_iter_init(&it, (SliceTable *)st, pos);
+	int b = bracket(st_iter_byte(&it)) - 1;
+	if(b < 0)
+		return SIZE_MAX;
+	bool back = b & 1;
+	size_t need[3] = {0};
+	need[b >> 1] = 1;
+	return match_bracket(st, metric_index(st, &st_brackets), st->root,
+						st->levels, back ? 0 : pos + 1,
+						back ? pos : st_size(st), back, need);
+}
+
+bool st_enclosing_brackets(const SliceTable *st, size_t pos, size_t *open,
+							size_t *close)
+{
+	int m = metric_index(st, &st_brackets), k = 0;
+	// the first opener of any class without its closer is the innermost
+	size_t need[3] = {1, 1, 1};
+	*open = match_bracket(st, m, st->root, st->levels, 0,
+						MIN(pos, st_size(st)), true, need);
+	if(*open == SIZE_MAX)
+		return false;
+	while(need[k])
+		k++;
+	memset(need, 0, sizeof need);
+	need[k] = 1;
+	*close = match_bracket(st, m, st->root, st->levels, *open + 1,
+							st_size(st), false, need);
+	*close = MIN(*close, st_size(st));
+	return true;
+}
+
+/* background line counting */
+
+struct stlinejob {
+	SliceTable *st; // our own snapshot, keeping the mappings alive
+	pthread_t thread;
+	atomic_size_t done;
+	atomic_bool cancel;
+	atomic_bool over; // the worker finished or stopped
+	size_t total;
+};
+
+static void *line_worker(void *arg)
+{
+	StLineJob *job = arg;
+	for(struct block *b = job->st->blocks; b; b = b->next) {
+		if(b->len < CHUNK)
+			continue;
+		struct chunksums *c = block_chunks(b, &st_newlines);
+		for(size_t k = 0; k * CHUNK < b->len; k++) {
+			if(atomic_load_explicit(&job->cancel, memory_order_relaxed))
+				goto over;
+			size_t count;
+			if(c) // else counted when needed
+				chunk_sum(b, c, k, &count);
+			atomic_fetch_add_explicit(&job->done,
+					MIN(CHUNK, b->len - k * CHUNK), memory_order_relaxed);
+		}
+	}
+over:
+	atomic_store_explicit(&job->over, true, memory_order_release);
+	return NULL;
+}
+
+StLineJob *st_count_lines_async(const SliceTable *st)
+{
+	StLineJob *job = malloc(sizeof *job);
+	if(!job)
+		return NULL;
+	if(!(job->st = st_clone(st))) {
+		free(job);
+		return NULL;
+	}
+	job->total = 0;
+	for(const struct block *b = st->blocks; b; b = b->next)
+		if(b->len >= CHUNK)
+			job->total += b->len;
+	atomic_init(&job->done, 0);
+	atomic_init(&job->cancel, false);
+	atomic_init(&job->over, false);
+	if((errno = pthread_create(&job->thread, NULL, line_worker, job)) == 0)
+		return job;
+	st_free(job->st);
+	free(job);
+	return NULL;
+}
+
+bool st_line_job_poll(const StLineJob *job, size_t *done, size_t *total)
+{
+	// first, so that done is final once it's over
+	bool over = atomic_load_explicit(&job->over, memory_order_acquire);
+	if(done)
+		*done = atomic_load_explicit(&job->done, memory_order_relaxed);
+	if(total)
+		*total = job->total;
+	return over;
+}
+
+void st_line_job_cancel(StLineJob *job)
+{
+	atomic_store_explicit(&job->cancel, true, memory_order_relaxed);
+}
+
+void st_line_job_wait(StLineJob *job)
+{
+	pthread_join(job->thread, NULL);
+	st_free(job->st);
+	free(job);
+}
+
+/* output */
+
+// calls fn on each slice overlapping [pos, pos+len) clipped to the range,
+// stopping early if fn returns false
+static bool walk_range(const struct node *root, int level,
+						size_t pos, size_t len, st_chunk_cb fn, void *ctx)
+{
+	int fill = node_fill(root, 0);
+	int i = 0;
+	while(i < fill && pos >= root->spans[i])
+		pos -= root->spans[i++];
+	for(; i < fill && len > 0; i++) {
+		// fetch the next node or slice while fn works on this one
+		if(i + 1 < fill)
+			__builtin_prefetch(root->child[i+1]);
+		size_t n = MIN(root->spans[i] - pos, len);
+		if(level == 1) {
+			if(!fn((char *)root->child[i] + pos, n, ctx))
+				return false;
+		} else if(!walk_range(root->child[i], level - 1, pos, n, fn, ctx))
+			return false;
+		len -= n;
+		pos = 0;
+	}
+	return true;
+}
+
+bool st_foreach_chunk(const SliceTable *st, size_t from, size_t to,
+						st_chunk_cb cb, void *ctx)
+{
+	to = MIN(to, st_size(st));
+	if(from >= to)
+		return true;
+	return walk_range(st->root, st->levels, from, to - from, cb, ctx);
+}
+
+static bool copy_chunk(const char *data, size_t len, void *ctx)
+{
+	char **buf = ctx;
+	memcpy(*buf, data, len);
+	*buf += len;
+	return true;
+}
+
+size_t st_read(const SliceTable *st, size_t pos, size_t len, char *buf)
+{
+	size_t size = st_size(st);
+	if(pos >= size)
+		return 0;
+	len = MIN(len, size - pos);
+	walk_range(st->root, st->levels, pos, len, copy_chunk, &buf);
+	return len;
+}
+
+char *st_read_alloc0(const SliceTable *st, size_t pos, size_t len)
+{
+	size_t size = st_size(st);
+	len = pos < size ? MIN(len, size - pos) : 0;
+	char *buf = malloc(len + 1);
+	if(!buf)
+		return NULL;
+	buf[st_read(st, pos, len, buf)] = '\0';
+	return buf;
+}
+
+struct iovecs {
+	struct iovec *out;
+	size_t max, count, covered;
+};
+
+static bool add_iovec(const char *data, size_t len, void *ctx)
+{
+	struct iovecs *v = ctx;
+	if(v->count == v->max)
+		return false;
+	v->out[v->count++] = (struct iovec){ (void *)data, len };
+	v->covered += len;
+	return true;
+}
+
+size_t st_iovec(const SliceTable *st, size_t pos, size_t len,
+				struct iovec *out, size_t max, size_t *next)
+{
+	size_t size = st_size(st);
+	pos = MIN(pos, size);
+	len = MIN(len, size - pos);
+	struct iovecs v = { out, max, 0, 0 };
+	walk_range(st->root, st->levels, pos, len, add_iovec, &v);
+	if(next)
+		*next = pos + v.covered;
+	return v.count;
+}
+
+// slices at least this large are copied from their backing file in-kernel
+#define COPY_THRESHOLD (1<<16)
+
+// shared with whoever is watching a background save
+struct progress {
+	atomic_size_t done;
+	atomic_bool cancel;
+	int notify; // written to every PROGRESS_STEP bytes
+};
+
+#define PROGRESS_STEP (1<<24)
+
+static void progress_notify(struct progress *p)
+{
+	// nonblocking. if the pipe is full the reader has yet to wake anyways
+	while(write(p->notify, "", 1) < 0 && errno == EINTR)
+		;
+}
+
+struct writer {
+	const SliceTable *st;
+	int fd;
+	off_t off; // where the pending batch goes, or -1 for the file offset
+	int iovcnt;
+	struct iovec iov[IOV_MAX];
+	size_t written;
+	struct progress *prog;
+};
+
+static bool writer_advance(struct writer *w, size_t n)
+{
+	w->written += n;
+	struct progress *p = w->prog;
+	if(!p)
+		return true;
+	size_t done = n + atomic_fetch_add_explicit(&p->done, n,
+												memory_order_relaxed);
+	if((done - n) / PROGRESS_STEP != done / PROGRESS_STEP)
+		progress_notify(p);
+	if(atomic_load_explicit(&p->cancel, memory_order_relaxed)) {
+		errno = ECANCELED;
+		return false;
+	}
+	return true;
+}
+
+// for non-blocking pipes and sockets: rather than spin, wait for the
+// reader to make room
+static bool wait_writable(int fd)
+{
+	struct pollfd p = { .fd = fd, .events = POLLOUT };
+	while(poll(&p, 1, -1) < 0)
+		if(errno != EINTR)
+			return false;
+	return true;
+}
+
+static bool writer_flush(struct writer *w)
+{
+	struct iovec *iov = w->iov;
+	int cnt = w->iovcnt;
+	while(cnt > 0) {
+		ssize_t n = w->off < 0 ? writev(w->fd, iov, cnt)
+			: pwritev(w->fd, iov, cnt, w->off);
+		if(n < 0) {
+			if(errno == EINTR || errno == EAGAIN && wait_writable(w->fd))
+				continue;
+			return false;
+		}
+		if(w->off >= 0)
+			w->off += n;
+		if(!writer_advance(w, n))
+			return false;
+		// skip whatever was written, then retry the rest
+		while(cnt > 0 && (size_t)n >= iov->iov_len) {
+			n -= iov->iov_len;
+			iov++, cnt--;
+		}
+		if(cnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+	w->iovcnt = 0;
+	return true;
+}
+
+// copies len bytes of BLK at DATA to the output without passing through
+// userspace. Returns the amount copied before the kernel refused, or -1
+static ssize_t copy_from_file(struct writer *w, const struct block *blk,
+								const char *data, size_t len)
+{
+	off_t off = data - blk->data;
+	size_t left = len;
+	struct blockfd *f = block_file_get(blk);
+	while(left > 0) {
+		ssize_t n = copy_file_range(f->fd, &off, w->fd,
+									w->off < 0 ? NULL : &w->off, left, 0);
+#ifdef __linux__
+		// e.g. cross-filesystem or a pipe. sendfile can't take an offset
+		if(n < 0 && errno != EINTR && w->off < 0)
+			n = sendfile(w->fd, f->fd, &off, left);
+#endif
+		if(n < 0) {
+			if(errno == EINTR || errno == EAGAIN && wait_writable(w->fd))
+				continue;
+			if(errno == EXDEV || errno == EINVAL || errno == ENOSYS ||
+					errno == EOPNOTSUPP || errno == EBADF)
+				break; // let writev have it
+			block_file_put(f);
+			return -1;
+		}
+		if(n == 0)
+			break;
+		left -= n;
+	}
+	block_file_put(f);
+	if(!writer_advance(w, len - left))
+		return -1;
+	return len - left;
+}
+
+static bool writer_add(const char *data, size_t len, void *ctx)
+{
+	struct writer *w = ctx;
+	const struct block *blk;
+	if(len >= COPY_THRESHOLD && (blk = mmap_block(w->st, data))) {
+		if(!writer_flush(w))
+			return false;
+		ssize_t n = copy_from_file(w, blk, data, len);
+		if(n < 0)
+			return false;
+		data += n;
+		len -= n;
+		if(len == 0)
+			return true;
+	}
+	w->iov[w->iovcnt++] = (struct iovec){ (char *)data, len };
+	return w->iovcnt < IOV_MAX || writer_flush(w);
+}
+
+// returns the file offset, or -1 with ENOSYS if positional writes are off
+static off_t positional_start(int fd)
+{
+	off_t start = lseek(fd, 0, SEEK_CUR);
+	int flags = fcntl(fd, F_GETFL);
+	struct stat sb;
+	// positional writes need a regular file, and O_APPEND ignores them
+	if(start < 0 || flags < 0 || flags & O_APPEND ||
+			fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode)) {
+		errno = ENOSYS;
+		return -1;
+	}
+	return start;
+}
+
+/* parallel: subtrees cover known byte ranges, so write them concurrently */
+
+#define PARALLEL_MIN (1<<26)
+#define PARALLEL_THREADS 16
+#define PARALLEL_CHUNK (1<<20) // smallest range handed to a thread
+
+struct ptask {
+	const struct node *node;
+	int level;
+	size_t pos, len;
+	off_t out;
+};
+
+struct pwriter {
+	const SliceTable *st;
+	int fd;
+	struct progress *prog;
+	struct ptask *tasks;
+	size_t ntasks, cap;
+	atomic_size_t next;
+	atomic_bool failed;
+	int err;
+	pthread_mutex_t lock; // for err
+};
+
+static bool ptask_add(struct pwriter *p, struct ptask task)
+{
+	if(p->ntasks == p->cap) {
+		p->cap = p->cap ? p->cap * 2 : 64;
+		struct ptask *tasks = realloc(p->tasks, p->cap * sizeof *tasks);
+		if(!tasks)
+			return false;
+		p->tasks = tasks;
+	}
+	p->tasks[p->ntasks++] = task;
+	return true;
+}
+
+// splits [pos, pos+len) of root into ranges of about chunk bytes, so large
+// slices are shared out as well as subtrees
+static bool ptask_collect(struct pwriter *p, const struct node *root,
+						int level, size_t pos, size_t len, off_t out,
+						size_t chunk)
+{
+	if(len <= chunk)
+		return ptask_add(p, (struct ptask){ root, level, pos, len, out });
+	if(level == 1) {
+		for(size_t n; len > 0; pos += n, len -= n, out += n)
+			if(!ptask_add(p, (struct ptask){
+						root, level, pos, n = MIN(len, chunk), out }))
+				return false;
+		return true;
+	}
+	int fill = node_fill(root, 0);
+	int i = 0;
+	while(i < fill && pos >= root->spans[i])
+		pos -= root->spans[i++];
+	for(; i < fill && len > 0; i++) {
+		size_t n = MIN(root->spans[i] - pos, len);
+		if(!ptask_collect(p, root->child[i], level - 1, pos, n, out, chunk))
+			return false;
+		out += n;
+		len -= n;
+		pos = 0;
+	}
+	return true;
+}
+
+static void *pwriter_run(void *arg)
+{
+	struct pwriter *p = arg;
+	struct writer *w = malloc(sizeof *w);
+	bool ok = w != NULL;
+	size_t t;
+	while(ok && !atomic_load_explicit(&p->failed, memory_order_relaxed) &&
+			(t = atomic_fetch_add(&p->next, 1)) < p->ntasks) {
+		struct ptask *task = &p->tasks[t];
+		*w = (struct writer){
+			.st = p->st, .fd = p->fd, .off = task->out, .prog = p->prog
+		};
+		ok = walk_range(task->node, task->level, task->pos, task->len,
+						writer_add, w) && writer_flush(w);
+	}
+	if(!ok) {
+		pthread_mutex_lock(&p->lock);
+		if(!atomic_exchange(&p->failed, true))
+			p->err = w ? errno : ENOMEM;
+		pthread_mutex_unlock(&p->lock);
+	}
+	free(w);
+	return NULL;
+}
+
+// returns -1 with ENOSYS if positional writes can't be used
+static ssize_t write_parallel(const SliceTable *st, int fd, size_t pos,
+								size_t len, struct progress *prog)
+{
+	off_t start = positional_start(fd);
+	if(start < 0)
+		return -1;
+	long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	int nthreads = MAX(1, MIN(cpus, PARALLEL_THREADS));
+	off_t oldsize = -1; // to shrink back to on failure, if we grew the file
+#ifdef __linux__
+	// reserve the extent up front rather than growing it from every thread
+	struct stat sb;
+	if(len > 0 && fstat(fd, &sb) == 0 &&
+			fallocate(fd, 0, start, len) == 0 && // merely an optimisation
+			sb.st_size < start + (off_t)len)
+		oldsize = sb.st_size;
+#endif
+	struct pwriter p = { .st = st, .fd = fd, .prog = prog };
+	atomic_init(&p.next, 0);
+	atomic_init(&p.failed, false);
+	pthread_mutex_init(&p.lock, NULL);
+	size_t chunk = MAX(len / (nthreads * 4), PARALLEL_CHUNK);
+	if(!ptask_collect(&p, st->root, st->levels, pos, len, start, chunk)) {
+		free(p.tasks);
+		pthread_mutex_destroy(&p.lock);
+		atomic_store(&p.failed, true);
+		p.err = errno;
+		goto out;
+	}
+	pthread_t threads[PARALLEL_THREADS];
+	int spawned = 0;
+	while(spawned < nthreads - 1 &&
+			pthread_create(&threads[spawned], NULL, pwriter_run, &p) == 0)
+		spawned++;
+	pwriter_run(&p); // and help out
+	for(int i = 0; i < spawned; i++)
+		pthread_join(threads[i], NULL);
+	free(p.tasks);
+	pthread_mutex_destroy(&p.lock);
+out:
+	if(atomic_load(&p.failed)) {
+		// don't leave the reserved extent behind as zeroes
+		if(oldsize >= 0)
+			ftruncate(fd, oldsize);
+		errno = p.err;
+		return -1;
+	}
+	lseek(fd, start + len, SEEK_SET);
+	return len;
+}
+
+#ifdef USE_URING
+/* io_uring: for fragmented tables, keep traversing while the kernel writes */
+
+#define URING_QD 64 // batches in flight
+#define URING_IOV 64 // slices per batch
+#define URING_MIN_LEAVES 256
+
+struct uring {
+	int fd;
+	unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+	unsigned *cq_head, *cq_tail, *cq_mask;
+	struct io_uring_sqe *sqes;
+	struct io_uring_cqe *cqes;
+	void *sq_ring, *cq_ring;
+	size_t sq_size, cq_size, sqes_size;
+};
+
+static bool uring_init(struct uring *r, unsigned entries)
+{
+	struct io_uring_params p;
+	memset(&p, 0, sizeof p);
+	if((r->fd = syscall(__NR_io_uring_setup, entries, &p)) < 0)
+		return false;
+	r->sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+	r->cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if(p.features & IORING_FEAT_SINGLE_MMAP)
+		r->sq_size = r->cq_size = MAX(r->sq_size, r->cq_size);
+	r->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+	r->sq_ring = mmap(NULL, r->sq_size, PROT_READ|PROT_WRITE,
+					MAP_SHARED|MAP_POPULATE, r->fd, IORING_OFF_SQ_RING);
+	r->cq_ring = (p.features & IORING_FEAT_SINGLE_MMAP) ? r->sq_ring :
+		mmap(NULL, r->cq_size, PROT_READ|PROT_WRITE,
+			MAP_SHARED|MAP_POPULATE, r->fd, IORING_OFF_CQ_RING);
+	r->sqes = mmap(NULL, r->sqes_size, PROT_READ|PROT_WRITE,
+					MAP_SHARED|MAP_POPULATE, r->fd, IORING_OFF_SQES);
+	if(r->sq_ring == MAP_FAILED || r->cq_ring == MAP_FAILED ||
+			r->sqes == MAP_FAILED) {
+		if(r->sq_ring != MAP_FAILED)
+			munmap(r->sq_ring, r->sq_size);
+		if(r->cq_ring != MAP_FAILED && r->cq_ring != r->sq_ring)
+			munmap(r->cq_ring, r->cq_size);
+		if(r->sqes != MAP_FAILED)
+			munmap(r->sqes, r->sqes_size);
+		close(r->fd);
+		return false;
+	}
+	char *sq = r->sq_ring, *cq = r->cq_ring;
+	r->sq_head = (unsigned *)(sq + p.sq_off.head);
+	r->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+	r->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+	r->sq_array = (unsigned *)(sq + p.sq_off.array);
+	r->cq_head = (unsigned *)(cq + p.cq_off.head);
+	r->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+	r->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+	r->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+	return true;
+}
+
+static void uring_exit(struct uring *r)
+{
+	munmap(r->sqes, r->sqes_size);
+	if(r->cq_ring != r->sq_ring)
+		munmap(r->cq_ring, r->cq_size);
+	munmap(r->sq_ring, r->sq_size);
+	close(r->fd);
+}
+
+// queues a positional writev, to be submitted by the next uring_enter
+static void uring_writev(struct uring *r, int fd, const struct iovec *iov,
+						int cnt, off_t off, uint64_t data)
+{
+	unsigned tail = *r->sq_tail; // we're the only producer
+	unsigned idx = tail & *r->sq_mask;
+	struct io_uring_sqe *sqe = &r->sqes[idx];
+	memset(sqe, 0, sizeof *sqe);
+	sqe->opcode = IORING_OP_WRITEV;
+	sqe->fd = fd;
+	sqe->addr = (uintptr_t)iov;
+	sqe->len = cnt;
+	sqe->off = off;
+	sqe->user_data = data;
+	r->sq_array[idx] = idx;
+	__atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static bool uring_enter(struct uring *r, unsigned submit, unsigned wait)
+{
+	while(syscall(__NR_io_uring_enter, r->fd, submit, wait,
+					wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0) < 0) {
+		// out of resources until some writes complete, so wait a little
+		if(errno == EAGAIN)
+			poll(&(struct pollfd){ .fd = r->fd, .events = POLLIN }, 1, 1);
+		else if(errno != EINTR)
+			return false;
+	}
+	return true;
+}
+
+struct uring_batch {
+	struct iovec iov[URING_IOV];
+	int cnt;
+	off_t off;
+};
+
+struct uring_writer {
+	struct uring ring;
+	struct writer w; // accounting, and synchronous paths
+	off_t off; // output position of the next slice
+	int cur; // batch being filled, or -1
+	int nfree, queued, inflight;
+	int free[URING_QD];
+	struct uring_batch batch[URING_QD];
+};
+
+static bool uring_complete(struct uring_writer *u, struct io_uring_cqe *cqe)
+{
+	struct uring_batch *b = &u->batch[cqe->user_data];
+	u->free[u->nfree++] = cqe->user_data;
+	u->inflight--;
+	if(cqe->res < 0) {
+		errno = -cqe->res;
+		return false;
+	}
+	size_t n = cqe->res;
+	if(!writer_advance(&u->w, n))
+		return false;
+	// short write: finish it synchronously
+	int i = 0;
+	while(i < b->cnt && n >= b->iov[i].iov_len)
+		n -= b->iov[i++].iov_len;
+	if(i == b->cnt)
+		return true;
+	struct writer *w = &u->w;
+	w->off = b->off + cqe->res;
+	w->iovcnt = b->cnt - i;
+	memcpy(w->iov, &b->iov[i], w->iovcnt * sizeof(struct iovec));
+	w->iov[0].iov_base = (char *)w->iov[0].iov_base + n;
+	w->iov[0].iov_len -= n;
+	return writer_flush(w);
+}
+
+// reap completions, waiting for at least wait of them
+static bool uring_reap(struct uring_writer *u, unsigned wait)
+{
+	struct uring *r = &u->ring;
+	unsigned submit = u->queued;
+	u->queued = 0;
+	u->inflight += submit;
+	if((submit || wait) && !uring_enter(r, submit, wait))
+		return false;
+	unsigned head = *r->cq_head;
+	unsigned tail = __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE);
+	bool ok = true;
+	for(; head != tail; head++)
+		ok &= uring_complete(u, &r->cqes[head & *r->cq_mask]);
+	__atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+	return ok;
+}
+
+static bool uring_submit_batch(struct uring_writer *u)
+{
+	if(u->cur < 0)
+		return true;
+	struct uring_batch *b = &u->batch[u->cur];
+	uring_writev(&u->ring, u->w.fd, b->iov, b->cnt, b->off, u->cur);
+	u->cur = -1;
+	// submit in groups, reaping whatever has finished meanwhile
+	return ++u->queued < URING_QD/4 || uring_reap(u, 0);
+}
+
+static bool uring_add(const char *data, size_t len, void *ctx)
+{
+	struct uring_writer *u = ctx;
+	const struct block *blk;
+	if(len >= COPY_THRESHOLD && (blk = mmap_block(u->w.st, data))) {
+		if(!uring_submit_batch(u))
+			return false;
+		u->w.off = u->off;
+		ssize_t n = copy_from_file(&u->w, blk, data, len);
+		if(n < 0)
+			return false;
+		u->off += n;
+		data += n;
+		len -= n;
+		if(len == 0)
+			return true;
+	}
+	if(u->cur < 0) {
+		while(u->nfree == 0)
+			if(!uring_reap(u, 1))
+				return false;
+		u->cur = u->free[--u->nfree];
+		u->batch[u->cur].cnt = 0;
+		u->batch[u->cur].off = u->off;
 	}
+	struct uring_batch *b = &u->batch[u->cur];
+	b->iov[b->cnt++] = (struct iovec){ (char *)data, len };
+	u->off += len;
+	return b->cnt < URING_IOV || uring_submit_batch(u);
 }
 
-bool st_iter_prev_chunk(SliceIter *it)
+// the leaves holding [pos, pos+len) of the subtree, counting up to max
+static size_t range_leaves(const struct node *node, int level, size_t pos,
+							size_t len, size_t max)
 {
-	int i = it->node_offset;
-	struct node *leaf = it->leaf;
-	if(it->pos == it->off) { // only true in first chunk
-		it->off = it->pos = 0;
-		it->data = leaf->child[0];
-		return false;
-	}
-	it->pos -= it->off + 1; // = 0 when [X][X|...
-	// fast path: same leaf
-	if(i > 0) {
-		it->node_offset--;
-		it->span = it->leaf->spans[i-1];
-		it->off = it->span - 1;
-		it->data = (char *)leaf->child[i-1] + it->off;
-		return true;
+	if(level == 1)
+		return 1;
+	size_t count = 0;
+	int fill = node_fill(node, 0);
+	int i = 0;
+	while(i < fill && pos >= node->spans[i])
+		pos -= node->spans[i++];
+	for(; i < fill && len > 0 && count < max; i++) {
+		size_t n = MIN(node->spans[i] - pos, len);
+		count += range_leaves(node->child[i], level - 1, pos, n, max - count);
+		len -= n;
+		pos = 0;
 	}
-	int si = 0;
-	struct stackentry *s = &it->stack[si];
-	while(si < iter_stacksize(it) && s->idx == 0)
-		s++, si++;
-	if(si < iter_stacksize(it)) {
-		it->stack[si].idx--;
-		while(--si >= 0) {
-			struct node *parent = it->stack[si+1].node;
-			it->stack[si].node = parent->child[node_fill(parent, 0) - 1];
-			it->stack[si].idx = node_fill(it->stack[si].node, 0) - 1;
-		}
-		int leaf_i = it->stack[0].idx;
-		struct node *leaf = (struct node *)it->stack[0].node->child[leaf_i];
-		int fill = node_fill(leaf, 0);
-		it->leaf = leaf;
-		it->node_offset = fill - 1;
-		it->span = leaf->spans[fill-1];
-		it->off = it->span - 1;
-		it->data = (char *)leaf->child[fill-1] + it->off;
-	} else
-		st_iter_to(it, it->pos);
-	return true;
+	return count;
 }
 
-char *st_iter_chunk(const SliceIter *it, size_t *len)
+// returns -1 with ENOSYS if io_uring can't be used, before writing anything
+static ssize_t write_uring(const SliceTable *st, int fd, size_t pos,
+							size_t len, struct progress *prog)
 {
-	*len = it->span;
-	return it->data - it->off;
+	off_t start = positional_start(fd);
+	if(start < 0)
+		return -1;
+	struct uring_writer *u = malloc(sizeof *u);
+	if(!u)
+		return -1;
+	if(!uring_init(&u->ring, URING_QD)) {
+		free(u);
+		errno = ENOSYS;
+		return -1;
+	}
+	u->w = (struct writer){ .st = st, .fd = fd, .prog = prog };
+	u->off = start;
+	u->cur = -1;
+	u->queued = u->inflight = 0;
+	u->nfree = URING_QD;
+	for(int i = 0; i < URING_QD; i++)
+		u->free[i] = i;
+
+	bool ok = walk_range(st->root, st->levels, pos, len, uring_add, u)
+		&& uring_submit_batch(u);
+	// the kernel still points at our batches, so drain even on failure
+	int err = errno;
+	while(u->queued || u->inflight) {
+		int left = u->queued + u->inflight;
+		if(!uring_reap(u, 1)) {
+			if(ok)
+				err = errno;
+			ok = false;
+			if(u->queued + u->inflight == left)
+				break; // the ring itself is broken
+		}
+	}
+	size_t written = u->w.written;
+	uring_exit(&u->ring);
+	free(u);
+	lseek(fd, start + written, SEEK_SET);
+	errno = err;
+	return ok ? (ssize_t)written : -1;
 }
+#endif
 
-int st_iter_byte(const SliceIter *it)
+static atomic_int writer_backend = ST_WRITER_AUTO;
+
+void st_set_writer(enum st_writer backend)
 {
-	return iter_off_end(it) ? -1 : (unsigned char)it->data[0];
+	atomic_store_explicit(&writer_backend, backend, memory_order_relaxed);
 }
 
-int st_iter_next_byte(SliceIter *it, size_t count)
+static ssize_t write_range(const SliceTable *st, int fd, size_t pos,
+							size_t len, struct progress *prog)
 {
-	if(iter_off_end(it))
+	size_t size = st_size(st);
+	if(pos > size) {
+		errno = EINVAL;
 		return -1;
+	}
+	len = MIN(len, size - pos);
+	int backend = atomic_load_explicit(&writer_backend, memory_order_relaxed);
+	if(backend == ST_WRITER_PARALLEL || backend == ST_WRITER_AUTO &&
+			len >= PARALLEL_MIN && sysconf(_SC_NPROCESSORS_ONLN) > 1) {
+		ssize_t n = write_parallel(st, fd, pos, len, prog);
+		if(n >= 0 || errno != ENOSYS)
+			return n;
+	}
+#ifdef USE_URING
+	if(backend == ST_WRITER_URING || backend == ST_WRITER_AUTO &&
+			range_leaves(st->root, st->levels, pos, len, URING_MIN_LEAVES)
+				>= URING_MIN_LEAVES) {
+		ssize_t n = write_uring(st, fd, pos, len, prog);
+		if(n >= 0 || errno != ENOSYS)
+			return n;
+	}
+#endif
 
-	size_t left = it->span - it->off;
-	if(count < left) {
-		it->off += count;
-		it->data += count;
-		it->pos += count;
-		return *it->data;
-	} // cursor ends up off end if no next chunk
-	st_dbg("iter_next_byte: wanted %zd, had %zd\n", count, left);
-	st_iter_next_chunk(it);
-	return st_iter_next_byte(it, count - left);
+	struct writer *w = malloc(sizeof *w);
+	if(!w)
+		return -1;
+	*w = (struct writer){ .st = st, .fd = fd, .off = -1, .prog = prog };
+	bool ok = walk_range(st->root, st->levels, pos, len, writer_add, w)
+		&& writer_flush(w);
+	ssize_t written = ok ? (ssize_t)w->written : -1;
+	free(w);
+	return written;
 }
 
-int st_iter_prev_byte(SliceIter *it, size_t count)
+ssize_t st_write_range(const SliceTable *st, int fd, size_t pos, size_t len)
 {
-	if(it->pos == 0)
-		return -1;
+	return write_range(st, fd, pos, len, NULL);
+}
 
-	size_t left = it->off;
-	if(count <= left) {
-		it->off -= count;
-		it->data -= count;
-		it->pos -= count;
-		return *it->data;
-	}
-	st_dbg("iter_prev_byte: wanted %zd, had %zd\n", count, left);
-	st_iter_prev_chunk(it);
-	return st_iter_prev_byte(it, count - left);
+ssize_t st_write(const SliceTable *st, int fd)
+{
+	return st_write_range(st, fd, 0, st_size(st));
 }
 
-// Assume utf-8
-// Assume that codepoints are not split across leaf boundaries
-// if this occurs, it means the user has already corrupted the file,
-// which should not be allowed. We never redistribute leaves, only merge
-long st_iter_cp(const SliceIter *it)
+/* saving */
+
+struct stsave {
+	SliceTable *st;
+	char *path;
+	char *tmppath; // ATOMIC: renamed over path on commit
+	int fd;
+	enum st_save_method method;
+	const struct block *orig; // mapping of the file at path, if any
+	size_t lowest; // INPLACE: first byte that isn't already in place
+	struct progress *prog;
+};
+
+// slices that still sit at their original offset in the target need not be
+// rewritten by an in-place save
+struct plan {
+	const struct block *orig;
+	size_t dst; // output position of the current slice
+	size_t lowest;
+	bool reads_orig; // a slice that must be rewritten is read from orig
+};
+
+static bool slice_in_place(const struct plan *p, const char *data)
 {
-	static const int utf8_len[] = {
-		1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
-		0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 3, 3, 4, 0 // high bit set
-	};
-	static const int utf8_lead_masks[] = { 0, 0xFF, 0x1F, 0x0F, 0x07 };
+	return p->orig && data == p->orig->data + p->dst;
+}
 
-	if(iter_off_end(it)) // otherwise we always have at least one byte
-		return -1;
-	unsigned char lead = *it->data;
+static bool plan_slice(const char *data, size_t len, void *ctx)
+{
+	struct plan *p = ctx;
+	if(!slice_in_place(p, data)) {
+		const struct block *o = p->orig;
+		p->lowest = MIN(p->lowest, p->dst);
+		p->reads_orig |= o && data >= o->data && data < o->data + o->len;
+	}
+	p->dst += len;
+	return true;
+}
 
-	int len = utf8_len[lead >> 3];
-	if((unsigned)len > it->span - it->off) // incomplete seq
-		return -1;
+// returns whether blk can be reached from a block list other than st's
+static bool block_shared(const SliceTable *st, const struct block *blk)
+{
+	for(const struct block *b = st->blocks; b; b = b->next) {
+		if(atomic_load_explicit(&b->refc, memory_order_relaxed) > 1)
+			return true;
+		if(b == blk)
+			return false;
+	}
+	return false;
+}
 
-	long cp = lead & utf8_lead_masks[len];
-	for(int i = 1; i < len; i++)
-		cp = cp<<6 | (it->data[i] & 0x3F);
-	return cp <= 0x10FFFF ? cp : -1;
+// creates a file next to path, named .<name>.st.XXXXXX unless unlinked
+static int tmpfile_near(const char *path, char **tmppath)
+{
+	char *dir = strdup(path), *base = strdup(path), *tmp = NULL;
+	int fd = -1;
+	if(!dir || !base)
+		goto out;
+#ifdef O_TMPFILE
+	if(!tmppath && (fd = open(dirname(dir), O_TMPFILE|O_RDWR, 0600)) >= 0)
+		goto out;
+#endif
+	size_t len = strlen(path) + sizeof("./..st.XXXXXX"); // dirname may be .
+	if(!(tmp = malloc(len)))
+		goto out;
+	strcpy(dir, path);
+	snprintf(tmp, len, "%s/.%s.st.XXXXXX", dirname(dir), basename(base));
+	if((fd = mkstemp(tmp)) >= 0 && !tmppath)
+		unlink(tmp);
+out:
+	free(dir);
+	free(base);
+	if(tmppath && fd >= 0)
+		*tmppath = tmp;
+	else
+		free(tmp);
+	return fd;
 }
 
-long st_iter_next_cp(SliceIter *it, size_t count)
+// The file we are going to overwrite is mapped. Move the mapping onto an
+// unlinked copy at the same address, so that slices (including those of
+// clones we can't see) keep their contents. Whoever is still copying from
+// the old fd keeps it open until they are done.
+static bool block_detach(struct block *blk, const char *path)
 {
-	/*
-	size_t chunk_remaining = it->span - it->off;
-	char *data;
-	// scan complete chunks so no it->off update is needed
-	// n.b. count = remaining means we need to at least reach the next chunk
-	while(count >= chunk_remaining) {
-		data = it->data + 1;
-		while(chunk_remaining--) { // could be vectorised?
-			if((*data++ & 0xC0) != 0x80) count--;
-		}
-		if(!st_iter_next_chunk(it))
-			return -1;
-		// at least chunk_remaining bytes must be checked
-		if((chunk_remaining = MIN(it->span, count)) > 0)
-			chunk_remaining = it->span;
+	struct blockfd *new = malloc(sizeof *new);
+	int fd = tmpfile_near(path, NULL);
+	if(!new || fd < 0) {
+		free(new);
+		if(fd >= 0)
+			close(fd);
+		return false;
 	}
-	*/
-	while(count > 0) {
-		int byte = st_iter_next_byte(it, 1);
-		if(byte == -1) return -1;
-		if((byte & 0xC0) != 0x80) count--;
+	struct blockfd *old = block_file_get(blk);
+	off_t off = 0;
+	while((size_t)off < blk->len) {
+		ssize_t n = copy_file_range(old->fd, &off, fd, NULL, blk->len - off, 0);
+		if(n <= 0)
+			break;
 	}
-	return st_iter_cp(it);
+	bool ok = true;
+	while(ok && (size_t)off < blk->len) { // no in-kernel copy
+		ssize_t n = write(fd, blk->data + off, blk->len - off);
+		ok = n >= 0 || errno == EINTR;
+		off += MAX(n, 0);
+	}
+	pthread_mutex_lock(&file_lock);
+	// another save may have detached it meanwhile
+	bool swap = ok && blk->file == old;
+	if(swap && mmap(blk->data, blk->len, PROT_READ, MAP_SHARED|MAP_FIXED,
+					fd, 0) == MAP_FAILED)
+		ok = swap = false;
+	if(swap) {
+		*new = (struct blockfd){ .refc = 1, .fd = fd };
+		blk->file = new;
+	}
+	pthread_mutex_unlock(&file_lock);
+	if(swap)
+		block_file_put(old); // the block's reference
+	else {
+		close(fd);
+		free(new);
+	}
+	block_file_put(old);
+	return ok;
 }
 
-long st_iter_prev_cp(SliceIter *it, size_t count)
+static bool save_begin_atomic(StSave *save, const struct stat *old)
 {
-	while(count > 0) {
-		int byte = st_iter_prev_byte(it, 1);
-		if(byte == -1) return -1;
-		if((byte & 0xC0) != 0x80) count--;
+	if(old && (S_ISLNK(old->st_mode) || old->st_nlink > 1)) {
+		errno = EPERM; // rename would break the link
+		return false;
 	}
-	return st_iter_cp(it);
+	if((save->fd = tmpfile_near(save->path, &save->tmppath)) < 0)
+		return false;
+	mode_t mode;
+	if(old)
+		mode = old->st_mode;
+	else {
+		mode_t mask = umask(0);
+		umask(mask);
+		mode = 0666 & ~mask;
+	}
+	if(fchmod(save->fd, mode) < 0 ||
+			(old && old->st_uid != getuid() && fchown(save->fd, old->st_uid, -1)) ||
+			(old && old->st_gid != getgid() && fchown(save->fd, -1, old->st_gid))) {
+		int err = errno;
+		close(save->fd);
+		unlink(save->tmppath);
+		free(save->tmppath);
+		save->fd = -1;
+		save->tmppath = NULL;
+		errno = err;
+		return false;
+	}
+	save->method = ST_SAVE_ATOMIC;
+	return true;
 }
 
-// go forwards count newlines, step forward once
-bool st_iter_next_line(SliceIter *it, size_t count)
+static bool save_begin_inplace(StSave *save, bool shared, bool reads_orig)
 {
-	while(count > 0) {
-		char *match = memchr(it->data, '\n', it->span - it->off);
-		if(match) {
-			size_t delta = match - it->data;
-			it->pos += delta;
-			it->off += delta;
-			it->data = match;
-			count--;
-			continue;
-		}
-		if(!st_iter_next_chunk(it))
+	const struct block *orig = save->orig;
+	size_t size = st_size(save->st);
+	// overwriting or truncating bytes that some slice may still read
+	if(orig && (reads_orig || shared &&
+				(save->lowest < orig->len || size < orig->len)))
+		if(!block_detach((struct block *)orig, save->path))
 			return false;
-	}
-	st_iter_next_byte(it, 1); // it's ok if it's off end
+	if((save->fd = open(save->path, O_WRONLY|O_CREAT, 0666)) < 0)
+		return false;
+	save->method = ST_SAVE_INPLACE;
 	return true;
 }
 
-// go backwards count+1 newlines, step forward once
-bool st_iter_prev_line(SliceIter *it, size_t count)
+StSave *st_save_begin(SliceTable *st, const char *path,
+						enum st_save_method method)
 {
-	count++;
-	while(count > 0) {
-		char *match = memrchr(it->data - it->off, '\n', it->off);
-		if(match) {
-			size_t delta = it->data - match;
-			it->pos -= delta;
-			it->off -= delta;
-			it->data = match;
-			count--;
+	StSave *save = calloc(1, sizeof *save);
+	if(!save)
+		return NULL;
+	*save = (StSave){ .st = st, .fd = -1, .path = strdup(path) };
+	if(!save->path)
+		goto fail;
+
+	struct stat old, linkstat;
+	bool exists = stat(path, &old) == 0;
+	if(!exists && errno != ENOENT)
+		goto fail;
+	if(exists && lstat(path, &linkstat) == 0 && S_ISLNK(linkstat.st_mode))
+		old.st_mode = linkstat.st_mode;
+	// find the mapping of the file we're overwriting
+	for(const struct block *b = st->blocks; exists && b; b = b->next) {
+		if(b->type != MMAP)
 			continue;
-		}
-		if(!st_iter_prev_chunk(it))
-			return false;
+		struct stat bs;
+		struct blockfd *f = block_file_get(b);
+		if(fstat(f->fd, &bs) == 0 &&
+				bs.st_dev == old.st_dev && bs.st_ino == old.st_ino)
+			save->orig = b;
+		block_file_put(f);
 	}
-	st_iter_next_byte(it, 1);
+	struct plan plan = { .orig = save->orig, .lowest = SIZE_MAX };
+	walk_range(st->root, st->levels, 0, st_size(st), plan_slice, &plan);
+	save->lowest = plan.lowest;
+	bool shared = save->orig && block_shared(st, save->orig);
+	// appending leaves every mapped byte untouched, so skip the copy
+	if(method == ST_SAVE_AUTO && save->orig && save->lowest >= save->orig->len
+			&& st_size(st) >= save->orig->len)
+		method = ST_SAVE_INPLACE;
+
+	errno = 0;
+	if(method != ST_SAVE_INPLACE &&
+			save_begin_atomic(save, exists ? &old : NULL))
+		return save;
+	if(method == ST_SAVE_ATOMIC || errno == ENOSPC)
+		goto fail;
+	if(save_begin_inplace(save, shared, plan.reads_orig))
+		return save;
+fail:
+	st_save_cancel(save);
+	return NULL;
+}
+
+struct inplace_writer {
+	struct plan plan;
+	struct writer w;
+};
+
+static bool inplace_slice(const char *data, size_t len, void *ctx)
+{
+	struct inplace_writer *iw = ctx;
+	struct writer *w = &iw->w;
+	if(slice_in_place(&iw->plan, data)) {
+		if(!writer_flush(w))
+			return false;
+		w->off += len;
+		if(!writer_advance(w, len))
+			return false;
+	} else if(!writer_add(data, len, w))
+		return false;
+	iw->plan.dst += len;
 	return true;
 }
 
+static bool save_write_inplace(StSave *save)
+{
+	SliceTable *st = save->st;
+	size_t size = st_size(st);
+	struct inplace_writer *iw = malloc(sizeof *iw);
+	if(!iw)
+		return false;
+	iw->plan = (struct plan){ .orig = save->orig };
+	iw->w = (struct writer){
+		.st = st, .fd = save->fd, .off = 0, .prog = save->prog
+	};
+	// n.b. everything below lowest is already in place
+	bool ok = walk_range(st->root, st->levels, 0, size, inplace_slice, iw)
+		&& writer_flush(&iw->w) && ftruncate(save->fd, size) == 0;
+	free(iw);
+	return ok;
+}
+
+static bool fsync_dir(const char *path)
+{
+	char *dir = strdup(path);
+	if(!dir)
+		return false;
+	int fd = open(dirname(dir), O_DIRECTORY|O_RDONLY);
+	free(dir);
+	if(fd < 0)
+		return false;
+	bool ok = fsync(fd) == 0 || errno == EINVAL;
+	return close(fd) == 0 && ok;
+}
+
+bool st_save_commit(StSave *save)
+{
+	bool ok = false;
+	size_t size;
+	switch(save->method) {
+		case ST_SAVE_ATOMIC:
+			size = st_size(save->st);
+			ok = write_range(save->st, save->fd, 0, size, save->prog)
+					== (ssize_t)size && fsync(save->fd) == 0;
+			ok = close(save->fd) == 0 && ok;
+			save->fd = -1;
+			if(ok && (ok = rename(save->tmppath, save->path) == 0)) {
+				free(save->tmppath);
+				save->tmppath = NULL;
+				ok = fsync_dir(save->path);
+			}
+			break;
+		case ST_SAVE_INPLACE:
+			ok = save_write_inplace(save) && fsync(save->fd) == 0;
+			break;
+		default:
+			break;
+	}
+	st_save_cancel(save);
+	return ok;
+}
+
+void st_save_cancel(StSave *save)
+{
+	int err = errno;
+	if(save->fd >= 0)
+		close(save->fd);
+	if(save->tmppath)
+		unlink(save->tmppath);
+	free(save->tmppath);
+	free(save->path);
+	free(save);
+	errno = err;
+}
+
+bool st_save(SliceTable *st, const char *path, enum st_save_method method)
+{
+	StSave *save = st_save_begin(st, path, method);
+	return save && st_save_commit(save);
+}
+
+/* background saving */
+
+struct stsavejob {
+	SliceTable *st; // our own snapshot
+	char *path;
+	enum st_save_method method;
+	st_save_cb cb;
+	void *ctx;
+	pthread_t thread;
+	struct progress prog;
+	int fds[2]; // pipe: readable on progress and completion
+	atomic_int state; // JOB_*
+	int err;
+};
+
+enum { JOB_RUNNING, JOB_OK, JOB_FAILED };
+
+static void *save_worker(void *arg)
+{
+	StSaveJob *job = arg;
+	StSave *save = st_save_begin(job->st, job->path, job->method);
+	bool ok = false;
+	if(save) {
+		save->prog = &job->prog;
+		ok = st_save_commit(save);
+	}
+	job->err = ok ? 0 : errno;
+	atomic_store_explicit(&job->state, ok ? JOB_OK : JOB_FAILED,
+							memory_order_release);
+	if(job->cb)
+		job->cb(ok, job->ctx);
+	progress_notify(&job->prog);
+	return NULL;
+}
+
+StSaveJob *st_save_async(const SliceTable *st, const char *path,
+						enum st_save_method method, st_save_cb cb, void *ctx)
+{
+	StSaveJob *job = calloc(1, sizeof *job);
+	if(!job)
+		return NULL;
+	job->fds[0] = job->fds[1] = -1;
+	if(!(job->path = strdup(path)) || pipe(job->fds) < 0)
+		goto fail;
+	for(int i = 0; i < 2; i++)
+		if(fcntl(job->fds[i], F_SETFL, O_NONBLOCK) < 0 ||
+				fcntl(job->fds[i], F_SETFD, FD_CLOEXEC) < 0)
+			goto fail;
+	if(!(job->st = st_clone(st)))
+		goto fail;
+	job->method = method;
+	job->cb = cb;
+	job->ctx = ctx;
+	job->prog.notify = job->fds[1];
+	atomic_init(&job->prog.done, 0);
+	atomic_init(&job->prog.cancel, false);
+	atomic_init(&job->state, JOB_RUNNING);
+	if((errno = pthread_create(&job->thread, NULL, save_worker, job)) == 0)
+		return job;
+	st_free(job->st);
+fail:
+	if(job->fds[0] >= 0) {
+		close(job->fds[0]);
+		close(job->fds[1]);
+	}
+	free(job->path);
+	free(job);
+	return NULL;
+}
+
+int st_save_job_fd(const StSaveJob *job)
+{
+	return job->fds[0];
+}
+
+bool st_save_job_poll(StSaveJob *job, size_t *done, size_t *total)
+{
+	char buf[64];
+	while(read(job->fds[0], buf, sizeof buf) > 0)
+		;
+	if(done)
+		*done = atomic_load_explicit(&job->prog.done, memory_order_relaxed);
+	if(total)
+		*total = st_size(job->st);
+	return atomic_load_explicit(&job->state, memory_order_acquire)
+		!= JOB_RUNNING;
+}
+
+void st_save_job_cancel(StSaveJob *job)
+{
+	atomic_store_explicit(&job->prog.cancel, true, memory_order_relaxed);
+}
+
+bool st_save_job_wait(StSaveJob *job)
+{
+	pthread_join(job->thread, NULL);
+	bool ok = atomic_load(&job->state) == JOB_OK;
+	st_free(job->st);
+	close(job->fds[0]);
+	close(job->fds[1]);
+	free(job->path);
+	int err = job->err;
+	free(job);
+	errno = err;
+	return ok;
+}
+
 /* debugging */
 
 void st_print_struct_sizes(void)
@@ -1328,9 +4664,115 @@ static bool check_recurse(struct node *root, int height, int level)
 	}
 }
 
+// measures the subtree again into total, comparing each slot's summaries
+static bool check_sums(const SliceTable *st, const struct node *node,
+						int level, size_t *total)
+{
+	const struct metricset *set = st->metrics;
+	const struct sums *s = node_sums(st, node);
+	if(!s || s->stale) {
+		st_dbg("%s summaries in ", s ? "stale" : "missing");
+		print_node(node, level);
+		return false;
+	}
+	int fill = node_fill(node, 0);
+	size_t slot[ST_MAX_METRICS * ST_METRIC_FIELDS];
+	for(int k = 0; k < set->n; k++)
+		measure(st, set->m[k], total + set->off[k], "", 0);
+	for(int i = 0; i < fill; i++) {
+		if(level > 1 && !check_sums(st, node->child[i], level - 1, slot))
+			return false;
+		if(level == 1 && (s->child[i] != node->child[i] ||
+							s->spans[i] != node->spans[i])) {
+			st_dbg("summarized slice %d isn't the leaf's in ", i);
+			print_node(node, level);
+			return false;
+		}
+		for(int k = 0; k < set->n; k++) {
+			const StMetric *m = set->m[k];
+			size_t *sum = slot + set->off[k];
+			if(level == 1)
+				measure(st, m, sum, node->child[i], node->spans[i]);
+			if(memcmp(sum, &s->data[i * set->stride + set->off[k]],
+						m->fields * sizeof(size_t))) {
+				st_dbg("summary %d of slot %d violation in ", k, i);
+				print_node(node, level);
+				return false;
+			}
+			combine(m, total + set->off[k], sum);
+		}
+	}
+	if(memcmp(total, &s->data[B * set->stride],
+				set->stride * sizeof(size_t))) {
+		st_dbg("node summary violation in ");
+		print_node(node, level);
+		return false;
+	}
+	return true;
+}
+
+// checks fill and that each subtree's entry is what deco_sum gives for it.
+// leafdepth starts at -1 and takes the depth of the first leaf found
+static bool deco_check(const struct deconode *node, int depth, int *leafdepth)
+{
+	if(node->n <= 0 || node->n >= DECO_B) {
+		st_dbg("deco fill violation: %d at depth %d\n", node->n, depth);
+		return false;
+	}
+	if(node->leaf) {
+		if(*leafdepth < 0)
+			*leafdepth = depth;
+		if(depth != *leafdepth) {
+			st_dbg("deco leaf at depth %d, not %d\n", depth, *leafdepth);
+			return false;
+		}
+		for(int i = 0; i < node->n; i++)
+			if(node->reach[i] < node->span[i]) {
+				st_dbg("deco %zu ends before its start\n", node->id[i]);
+				return false;
+			}
+		return true;
+	}
+	for(int i = 0; i < node->n; i++) {
+		size_t span, reach;
+		if(!deco_check(node->child[i], depth + 1, leafdepth))
+			return false;
+		deco_sum(node->child[i], &span, &reach);
+		if(span != node->span[i] || reach != node->reach[i]) {
+			st_dbg("deco slot %d at depth %d: span %zu reach %zu, "
+					"child sums %zu %zu\n", i, depth, node->span[i],
+					node->reach[i], span, reach);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool check_decos(const SliceTable *st)
+{
+	const struct deconode *root = st->decos;
+	size_t span, reach;
+	int leafdepth = -1;
+	if(!root->leaf && root->n < 2) {
+		st_dbg("deco root with a single child\n");
+		return false;
+	}
+	if(!deco_check(root, 0, &leafdepth))
+		return false;
+	deco_sum(root, &span, &reach);
+	if(reach > st_size(st)) {
+		st_dbg("decos reach %zu, past the end at %zu\n", reach, st_size(st));
+		return false;
+	}
+	return true;
+}
+
 bool st_check_invariants(const SliceTable *st)
 {
-	return check_recurse(st->root, st->levels, st->levels);
+	size_t total[ST_MAX_METRICS * ST_METRIC_FIELDS];
+	return check_recurse(st->root, st->levels, st->levels) &&
+		(!st->metrics || check_sums(st, st->root, st->levels, total)) &&
+		(!st->decos || check_decos(st));
 }
 
 /* global queue */
@@ -1372,16 +4814,8 @@ void st_pprint(const SliceTable *st)
 
 void st_dump(const SliceTable *st, FILE *file)
 {
-	enqueue((struct q){ st->levels, st->root });
-	struct q *next;
-	while((next = dequeue()) != NULL)
-		if(next->level > 1)
-			for(int i = 0; i < node_fill(next->node, 0); i++)
-				enqueue((struct q){ next->level-1, next->node->child[i] });
-		else // start dumping
-			for(int i = 0; i < node_fill(next->node, 0); i++)
-				fprintf(file, "%.*s", (int)next->node->spans[i],
-						(char *)next->node->child[i]);
+	fflush(file);
+	st_write(st, fileno(file));
 }
 
 /* dot output */
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "st.h"
+
+/* btree.c's iterator layout, so iterators can live on the stack (see
+ * st_iter_init) and hot loops can step within a chunk without a call
+ * n.b. the other backends don't provide this
+ */
+
+struct node;
+
+struct st_stackentry {
+	struct node *node;
+	int idx;
+};
+
+// inner nodes are at least half full, so this covers more slices than
+// could ever fit in memory
+#define ST_MAXLEVELS 24
+struct sliceiter {
+	size_t span; // span of current slice
+	size_t off; // offset into slice
+	char *data;
+	size_t pos; // absolute position
+	struct node *leaf;
+	int node_offset;
+	// path from the leaf's parent (stack[0]) to the root (stack[levels-2])
+	struct st_stackentry stack[ST_MAXLEVELS - 1];
+	int levels; // of st when the path was taken
+	unsigned long shape; // likewise, see st_iter_fixup
+	SliceTable *st;
+	bool pinned; // st is a clone owned by the iterator
+};
+
+// as st_iter_byte, st_iter_next_byte(it, 1) and st_iter_prev_byte(it, 1),
+// only calling into btree.c at the ends of chunks
+
+static inline int st_iter_byte_inline(const SliceIter *it)
+{
+	return it->off == it->span ? -1 : (unsigned char)*it->data;
+}
+
+static inline int st_iter_next_byte_inline(SliceIter *it)
+{
+	if(it->off + 1 < it->span) {
+		it->off++;
+		it->data++;
+		it->pos++;
+		return (unsigned char)*it->data;
+	}
+	return st_iter_next_byte(it, 1);
+}
+
+static inline int st_iter_prev_byte_inline(SliceIter *it)
+{
+	if(it->off > 0) {
+		it->off--;
+		it->data--;
+		it->pos--;
+		return (unsigned char)*it->data;
+	}
+	return st_iter_prev_byte(it, 1);
+}
@@ -4,10 +4,151 @@
 
 #include "st.h"
 
+// the decorations st should have, moved by the rules in st.h
+struct deco {
+	size_t start, end, id;
+	int flags;
+};
+static struct deco *decos, *found;
+static size_t ndecos, nfound;
+
+static void decos_edit(size_t pos, size_t deleted, size_t len)
+{
+	size_t to = pos + deleted, w = 0;
+	for(size_t i = 0; i < ndecos; i++) {
+		struct deco d = decos[i];
+		if(d.flags & ST_DECO_DELETE && deleted && pos <= d.start &&
+				d.end <= to && (d.start < d.end || pos < d.start && d.start < to))
+			continue;
+		size_t start = d.start < pos ? d.start
+			: d.start < to ? pos : d.start - deleted + len;
+		if(d.start == d.end)
+			d.end = start;
+		else if(d.end > pos || d.end == pos && d.flags & ST_DECO_GROW)
+			d.end = MAX(d.end, to) - deleted + len;
+		d.start = start;
+		decos[w++] = d;
+	}
+	ndecos = w;
+}
+
+static void decos_remove(size_t from, size_t to, size_t id)
+{
+	size_t w = 0;
+	for(size_t i = 0; i < ndecos; i++) {
+		struct deco d = decos[i];
+		if(!((id == ST_DECO_ANY || d.id == id) && d.start < to &&
+				(d.end > from || d.start >= from)))
+			decos[w++] = d;
+	}
+	ndecos = w;
+}
+
+// likewise for marks, by id. There are never more than MARKS at once, so
+// ids past it mean removed ones weren't reused
+#define MARKS 64
+static struct {
+	size_t pos; // SIZE_MAX once deleted with their text
+	int flags;
+	bool used;
+} marks[MARKS];
+static size_t nmarks;
+
+static void marks_edit(size_t pos, size_t deleted, size_t len)
+{
+	for(int k = 0; k < MARKS; k++) {
+		size_t p = marks[k].pos;
+		if(!marks[k].used || p == SIZE_MAX || p < pos)
+			continue;
+		if(p > pos + deleted)
+			marks[k].pos = p - deleted + len;
+		else if(marks[k].flags & ST_MARK_DELETE && p > pos && p < pos + deleted)
+			marks[k].pos = SIZE_MAX;
+		else
+			marks[k].pos = pos + (marks[k].flags & ST_MARK_RIGHT ? len : 0);
+	}
+}
+
+static void mark_add(StMarks *m, size_t pos, int flags)
+{
+	if(nmarks == MARKS)
+		return;
+	size_t id = st_mark_add(m, pos, flags);
+	assert(id < MARKS && !marks[id].used);
+	marks[id].pos = pos;
+	marks[id].flags = flags;
+	marks[id].used = true;
+	nmarks++;
+}
+
+static bool marks_match(const StMarks *m)
+{
+	size_t n, live = 0;
+	const size_t *sorted = st_marks_sorted(m, &n);
+	for(size_t i = 1; i < n; i++)
+		if(sorted[i-1] > sorted[i])
+			return false;
+	for(int k = 0; k < MARKS; k++)
+		if(marks[k].used) {
+			if(st_mark_pos(m, k) != marks[k].pos)
+				return false;
+			live += marks[k].pos != SIZE_MAX;
+		}
+	return n == live;
+}
+
+// both apply the edit
+static void edited(size_t pos, size_t deleted, size_t len)
+{
+	decos_edit(pos, deleted, len);
+	marks_edit(pos, deleted, len);
+}
+
+static bool deco_found(size_t start, size_t end, size_t id, int flags,
+						void *ctx)
+{
+	found = realloc(found, (nfound + 1) * sizeof *found);
+	found[nfound++] = (struct deco){ start, end, id, flags };
+	return true;
+}
+
+static int deco_cmp(const void *a, const void *b)
+{
+	const struct deco *x = a, *y = b;
+	if(x->start != y->start)
+		return x->start < y->start ? -1 : 1;
+	if(x->end != y->end)
+		return x->end < y->end ? -1 : 1;
+	if(x->id != y->id)
+		return x->id < y->id ? -1 : 1;
+	return x->flags - y->flags;
+}
+
+static bool decos_match(const SliceTable *st)
+{
+	nfound = 0;
+	st_foreach_deco(st, 0, SIZE_MAX, deco_found, NULL);
+	if(nfound != ndecos)
+		return false;
+	if(ndecos) {
+		qsort(decos, ndecos, sizeof *decos, deco_cmp);
+		qsort(found, nfound, sizeof *found, deco_cmp);
+	}
+	for(size_t i = 0; i < ndecos; i++)
+		if(deco_cmp(&decos[i], &found[i]))
+			return false;
+	return true;
+}
+
 int main(void)
 {
-	SliceTable *st = st_new();
+	SliceTable *st = st_new(), *clone = NULL;
 	st_insert(st, 0, "x", 1);
+	StMarks *m = st_marks_new(st);
+	// summaries are checked by st_check_invariants
+	st_add_metric(st, &st_newlines);
+	st_add_metric(st, &st_line_lengths);
+	st_add_metric(st, &st_brackets);
 #ifdef AFL_DEBUG
 	FILE *sm = fopen("tests/case", "r");
 	//FILE *sm = fopen("mini", "r");
@@ -25,24 +166,102 @@ int main(void)
 			continue;
 
 		linelen -= 2;
-		bool op = *s++ % 2;
+		unsigned char c = *s++;
+		bool op = c % 2;
 		unsigned i = *s++;
 		unsigned j = *s++;
 
 		i = 1000*i + j;
 		size_t pos = st_size(st) - (i % st_size(st) + i%2);
 
-		if(op)
+		size_t size = st_size(st), start = pos;
+		size_t end = pos + MIN(linelen, size - pos);
+		switch(c >> 5) {
+		case 3: // end inside the first of the adjacent edits below
+			if(!op || !(c & 8))
+				break;
+			start = pos / 2;
+			end = MIN(pos + 1, size);
+			mark_add(m, end, c >> 2 & 3);
+			// fallthrough
+		case 1: case 4: case 5: // decorate what the edit is about to touch
+			if(st_deco_add(st, start, end, j % 8, c >> 2 & 3)) {
+				decos = realloc(decos, (ndecos + 1) * sizeof *decos);
+				decos[ndecos++] = (struct deco){ start, end, j % 8, c >> 2 & 3 };
+			}
+			break;
+		case 2:
+			st_deco_remove(st, pos, end + 1, c & 4 ? ST_DECO_ANY : j % 8);
+			decos_remove(pos, end + 1, c & 4 ? ST_DECO_ANY : j % 8);
+			break;
+		case 6:
+			mark_add(m, pos, c >> 2 & 3);
+			break;
+		case 7: // drop one, freeing its id, or bring it here
+			if(!marks[j % MARKS].used)
+				break;
+			if(c & 4) {
+				st_mark_remove(m, j % MARKS);
+				marks[j % MARKS].used = false;
+				nmarks--;
+			} else {
+				bool ok = st_mark_move(m, j % MARKS, pos);
+				assert(ok);
+				marks[j % MARKS].pos = pos;
+			}
+			break;
+		}
+		if(c >> 5 == 3 && op) {
+			// the line in two edits, the second replacing a few bytes
+			size_t half = linelen / 2, at = pos / 2, deleted = 0;
+			if(c & 8) { // the first right before it, replacing some too
+				at = pos;
+				deleted = MIN(j / 4 % 4, size - pos);
+				pos += deleted;
+			}
+			struct st_edit edits[2] = {
+				{ at, deleted, s, half },
+				{ pos, MIN(j % 4, size - pos), s + half, linelen - half },
+			};
+			bool ok = st_edit_batch(st, edits, 2);
+			assert(ok);
+			size_t delta = 0;
+			for(int e = 0; e < 2; e++) {
+				edited(edits[e].pos + delta, edits[e].deleted, edits[e].len);
+				delta += edits[e].len - edits[e].deleted;
+			}
+		} else if(op) {
 			st_insert(st, pos, s, linelen);
-		else
-			st_delete(st, pos, linelen % st_size(st));
+			edited(pos, 0, linelen);
+		} else {
+			size_t deleted = linelen % st_size(st);
+			if(st_delete(st, pos, deleted))
+				edited(pos, deleted, 0);
+		}
+		// keep a snapshot sharing nodes with st, sometimes with a metric set
+		// of its own
+		if((c >> 1) % 8 == 0) {
+			if(clone)
+				st_free(clone);
+			clone = st_clone(st);
+			if(c & 0x10)
+				st_add_metric(clone, &st_codepoints);
+		}
 #ifdef AFL_DEBUG
 		st_pprint(st);
 #endif
 		assert(st_check_invariants(st));
+		assert(!clone || st_check_invariants(clone));
+		assert(decos_match(st));
+		assert(marks_match(m));
 	}
 #ifdef AFL_DEBUG
 	fclose(sm);
 #endif
+	if(clone)
+		st_free(clone);
+	st_marks_free(m);
 	st_free(st);
+	free(decos);
+	free(found);
 }
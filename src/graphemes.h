@@ -0,0 +1,491 @@
+// generated by graphemes.pl from Unicode 14.0.0, do not edit
+
+#pragma once
+#include <stdint.h>
+
+enum gcb {
+	GCB_OTHER, GCB_CR, GCB_LF, GCB_CONTROL, GCB_EXTEND, GCB_ZWJ, GCB_RI,
+	GCB_PREPEND, GCB_SPACINGMARK, GCB_L, GCB_V, GCB_T, GCB_LV, GCB_LVT,
+	GCB_PICTO, // Extended_Pictographic
+};
+
+#define R(from, prop) ((uint32_t)(from) << 8 | GCB_##prop)
+// the property of codepoints from each start up to the next one's
+static const uint32_t gcb_ranges[] = {
+	R(0x0, CONTROL), R(0xA, LF), R(0xB, CONTROL), R(0xD, CR),
+	R(0xE, CONTROL), R(0x20, OTHER), R(0x7F, CONTROL), R(0xA0, OTHER),
+	R(0xA9, PICTO), R(0xAA, OTHER), R(0xAD, CONTROL), R(0xAE, PICTO),
+	R(0xAF, OTHER), R(0x300, EXTEND), R(0x370, OTHER), R(0x483, EXTEND),
+	R(0x48A, OTHER), R(0x591, EXTEND), R(0x5BE, OTHER), R(0x5BF, EXTEND),
+	R(0x5C0, OTHER), R(0x5C1, EXTEND), R(0x5C3, OTHER), R(0x5C4, EXTEND),
+	R(0x5C6, OTHER), R(0x5C7, EXTEND), R(0x5C8, OTHER), R(0x600, PREPEND),
+	R(0x606, OTHER), R(0x610, EXTEND), R(0x61B, OTHER), R(0x61C, CONTROL),
+	R(0x61D, OTHER), R(0x64B, EXTEND), R(0x660, OTHER), R(0x670, EXTEND),
+	R(0x671, OTHER), R(0x6D6, EXTEND), R(0x6DD, PREPEND), R(0x6DE, OTHER),
+	R(0x6DF, EXTEND), R(0x6E5, OTHER), R(0x6E7, EXTEND), R(0x6E9, OTHER),
+	R(0x6EA, EXTEND), R(0x6EE, OTHER), R(0x70F, PREPEND), R(0x710, OTHER),
+	R(0x711, EXTEND), R(0x712, OTHER), R(0x730, EXTEND), R(0x74B, OTHER),
+	R(0x7A6, EXTEND), R(0x7B1, OTHER), R(0x7EB, EXTEND), R(0x7F4, OTHER),
+	R(0x7FD, EXTEND), R(0x7FE, OTHER), R(0x816, EXTEND), R(0x81A, OTHER),
+	R(0x81B, EXTEND), R(0x824, OTHER), R(0x825, EXTEND), R(0x828, OTHER),
+	R(0x829, EXTEND), R(0x82E, OTHER), R(0x859, EXTEND), R(0x85C, OTHER),
+	R(0x890, PREPEND), R(0x892, OTHER), R(0x898, EXTEND), R(0x8A0, OTHER),
+	R(0x8CA, EXTEND), R(0x8E2, PREPEND), R(0x8E3, EXTEND),
+	R(0x903, SPACINGMARK), R(0x904, OTHER), R(0x93A, EXTEND),
+	R(0x93B, SPACINGMARK), R(0x93C, EXTEND), R(0x93D, OTHER),
+	R(0x93E, SPACINGMARK), R(0x941, EXTEND), R(0x949, SPACINGMARK),
+	R(0x94D, EXTEND), R(0x94E, SPACINGMARK), R(0x950, OTHER),
+	R(0x951, EXTEND), R(0x958, OTHER), R(0x962, EXTEND), R(0x964, OTHER),
+	R(0x981, EXTEND), R(0x982, SPACINGMARK), R(0x984, OTHER),
+	R(0x9BC, EXTEND), R(0x9BD, OTHER), R(0x9BE, EXTEND),
+	R(0x9BF, SPACINGMARK), R(0x9C1, EXTEND), R(0x9C5, OTHER),
+	R(0x9C7, SPACINGMARK), R(0x9C9, OTHER), R(0x9CB, SPACINGMARK),
+	R(0x9CD, EXTEND), R(0x9CE, OTHER), R(0x9D7, EXTEND), R(0x9D8, OTHER),
+	R(0x9E2, EXTEND), R(0x9E4, OTHER), R(0x9FE, EXTEND), R(0x9FF, OTHER),
+	R(0xA01, EXTEND), R(0xA03, SPACINGMARK), R(0xA04, OTHER),
+	R(0xA3C, EXTEND), R(0xA3D, OTHER), R(0xA3E, SPACINGMARK),
+	R(0xA41, EXTEND), R(0xA43, OTHER), R(0xA47, EXTEND), R(0xA49, OTHER),
+	R(0xA4B, EXTEND), R(0xA4E, OTHER), R(0xA51, EXTEND), R(0xA52, OTHER),
+	R(0xA70, EXTEND), R(0xA72, OTHER), R(0xA75, EXTEND), R(0xA76, OTHER),
+	R(0xA81, EXTEND), R(0xA83, SPACINGMARK), R(0xA84, OTHER),
+	R(0xABC, EXTEND), R(0xABD, OTHER), R(0xABE, SPACINGMARK),
+	R(0xAC1, EXTEND), R(0xAC6, OTHER), R(0xAC7, EXTEND),
+	R(0xAC9, SPACINGMARK), R(0xACA, OTHER), R(0xACB, SPACINGMARK),
+	R(0xACD, EXTEND), R(0xACE, OTHER), R(0xAE2, EXTEND), R(0xAE4, OTHER),
+	R(0xAFA, EXTEND), R(0xB00, OTHER), R(0xB01, EXTEND),
+	R(0xB02, SPACINGMARK), R(0xB04, OTHER), R(0xB3C, EXTEND),
+	R(0xB3D, OTHER), R(0xB3E, EXTEND), R(0xB40, SPACINGMARK),
+	R(0xB41, EXTEND), R(0xB45, OTHER), R(0xB47, SPACINGMARK),
+	R(0xB49, OTHER), R(0xB4B, SPACINGMARK), R(0xB4D, EXTEND),
+	R(0xB4E, OTHER), R(0xB55, EXTEND), R(0xB58, OTHER), R(0xB62, EXTEND),
+	R(0xB64, OTHER), R(0xB82, EXTEND), R(0xB83, OTHER), R(0xBBE, EXTEND),
+	R(0xBBF, SPACINGMARK), R(0xBC0, EXTEND), R(0xBC1, SPACINGMARK),
+	R(0xBC3, OTHER), R(0xBC6, SPACINGMARK), R(0xBC9, OTHER),
+	R(0xBCA, SPACINGMARK), R(0xBCD, EXTEND), R(0xBCE, OTHER),
+	R(0xBD7, EXTEND), R(0xBD8, OTHER), R(0xC00, EXTEND),
+	R(0xC01, SPACINGMARK), R(0xC04, EXTEND), R(0xC05, OTHER),
+	R(0xC3C, EXTEND), R(0xC3D, OTHER), R(0xC3E, EXTEND),
+	R(0xC41, SPACINGMARK), R(0xC45, OTHER), R(0xC46, EXTEND),
+	R(0xC49, OTHER), R(0xC4A, EXTEND), R(0xC4E, OTHER), R(0xC55, EXTEND),
+	R(0xC57, OTHER), R(0xC62, EXTEND), R(0xC64, OTHER), R(0xC81, EXTEND),
+	R(0xC82, SPACINGMARK), R(0xC84, OTHER), R(0xCBC, EXTEND),
+	R(0xCBD, OTHER), R(0xCBE, SPACINGMARK), R(0xCBF, EXTEND),
+	R(0xCC0, SPACINGMARK), R(0xCC2, EXTEND), R(0xCC3, SPACINGMARK),
+	R(0xCC5, OTHER), R(0xCC6, EXTEND), R(0xCC7, SPACINGMARK),
+	R(0xCC9, OTHER), R(0xCCA, SPACINGMARK), R(0xCCC, EXTEND),
+	R(0xCCE, OTHER), R(0xCD5, EXTEND), R(0xCD7, OTHER), R(0xCE2, EXTEND),
+	R(0xCE4, OTHER), R(0xD00, EXTEND), R(0xD02, SPACINGMARK),
+	R(0xD04, OTHER), R(0xD3B, EXTEND), R(0xD3D, OTHER), R(0xD3E, EXTEND),
+	R(0xD3F, SPACINGMARK), R(0xD41, EXTEND), R(0xD45, OTHER),
+	R(0xD46, SPACINGMARK), R(0xD49, OTHER), R(0xD4A, SPACINGMARK),
+	R(0xD4D, EXTEND), R(0xD4E, PREPEND), R(0xD4F, OTHER), R(0xD57, EXTEND),
+	R(0xD58, OTHER), R(0xD62, EXTEND), R(0xD64, OTHER), R(0xD81, EXTEND),
+	R(0xD82, SPACINGMARK), R(0xD84, OTHER), R(0xDCA, EXTEND),
+	R(0xDCB, OTHER), R(0xDCF, EXTEND), R(0xDD0, SPACINGMARK),
+	R(0xDD2, EXTEND), R(0xDD5, OTHER), R(0xDD6, EXTEND), R(0xDD7, OTHER),
+	R(0xDD8, SPACINGMARK), R(0xDDF, EXTEND), R(0xDE0, OTHER),
+	R(0xDF2, SPACINGMARK), R(0xDF4, OTHER), R(0xE31, EXTEND),
+	R(0xE32, OTHER), R(0xE33, SPACINGMARK), R(0xE34, EXTEND),
+	R(0xE3B, OTHER), R(0xE47, EXTEND), R(0xE4F, OTHER), R(0xEB1, EXTEND),
+	R(0xEB2, OTHER), R(0xEB3, SPACINGMARK), R(0xEB4, EXTEND),
+	R(0xEBD, OTHER), R(0xEC8, EXTEND), R(0xECE, OTHER), R(0xF18, EXTEND),
+	R(0xF1A, OTHER), R(0xF35, EXTEND), R(0xF36, OTHER), R(0xF37, EXTEND),
+	R(0xF38, OTHER), R(0xF39, EXTEND), R(0xF3A, OTHER),
+	R(0xF3E, SPACINGMARK), R(0xF40, OTHER), R(0xF71, EXTEND),
+	R(0xF7F, SPACINGMARK), R(0xF80, EXTEND), R(0xF85, OTHER),
+	R(0xF86, EXTEND), R(0xF88, OTHER), R(0xF8D, EXTEND), R(0xF98, OTHER),
+	R(0xF99, EXTEND), R(0xFBD, OTHER), R(0xFC6, EXTEND), R(0xFC7, OTHER),
+	R(0x102D, EXTEND), R(0x1031, SPACINGMARK), R(0x1032, EXTEND),
+	R(0x1038, OTHER), R(0x1039, EXTEND), R(0x103B, SPACINGMARK),
+	R(0x103D, EXTEND), R(0x103F, OTHER), R(0x1056, SPACINGMARK),
+	R(0x1058, EXTEND), R(0x105A, OTHER), R(0x105E, EXTEND),
+	R(0x1061, OTHER), R(0x1071, EXTEND), R(0x1075, OTHER),
+	R(0x1082, EXTEND), R(0x1083, OTHER), R(0x1084, SPACINGMARK),
+	R(0x1085, EXTEND), R(0x1087, OTHER), R(0x108D, EXTEND),
+	R(0x108E, OTHER), R(0x109D, EXTEND), R(0x109E, OTHER), R(0x1100, L),
+	R(0x1160, V), R(0x11A8, T), R(0x1200, OTHER), R(0x135D, EXTEND),
+	R(0x1360, OTHER), R(0x1712, EXTEND), R(0x1715, SPACINGMARK),
+	R(0x1716, OTHER), R(0x1732, EXTEND), R(0x1734, SPACINGMARK),
+	R(0x1735, OTHER), R(0x1752, EXTEND), R(0x1754, OTHER),
+	R(0x1772, EXTEND), R(0x1774, OTHER), R(0x17B4, EXTEND),
+	R(0x17B6, SPACINGMARK), R(0x17B7, EXTEND), R(0x17BE, SPACINGMARK),
+	R(0x17C6, EXTEND), R(0x17C7, SPACINGMARK), R(0x17C9, EXTEND),
+	R(0x17D4, OTHER), R(0x17DD, EXTEND), R(0x17DE, OTHER),
+	R(0x180B, EXTEND), R(0x180E, CONTROL), R(0x180F, EXTEND),
+	R(0x1810, OTHER), R(0x1885, EXTEND), R(0x1887, OTHER),
+	R(0x18A9, EXTEND), R(0x18AA, OTHER), R(0x1920, EXTEND),
+	R(0x1923, SPACINGMARK), R(0x1927, EXTEND), R(0x1929, SPACINGMARK),
+	R(0x192C, OTHER), R(0x1930, SPACINGMARK), R(0x1932, EXTEND),
+	R(0x1933, SPACINGMARK), R(0x1939, EXTEND), R(0x193C, OTHER),
+	R(0x1A17, EXTEND), R(0x1A19, SPACINGMARK), R(0x1A1B, EXTEND),
+	R(0x1A1C, OTHER), R(0x1A55, SPACINGMARK), R(0x1A56, EXTEND),
+	R(0x1A57, SPACINGMARK), R(0x1A58, EXTEND), R(0x1A5F, OTHER),
+	R(0x1A60, EXTEND), R(0x1A61, OTHER), R(0x1A62, EXTEND),
+	R(0x1A63, OTHER), R(0x1A65, EXTEND), R(0x1A6D, SPACINGMARK),
+	R(0x1A73, EXTEND), R(0x1A7D, OTHER), R(0x1A7F, EXTEND),
+	R(0x1A80, OTHER), R(0x1AB0, EXTEND), R(0x1ACF, OTHER),
+	R(0x1B00, EXTEND), R(0x1B04, SPACINGMARK), R(0x1B05, OTHER),
+	R(0x1B34, EXTEND), R(0x1B3B, SPACINGMARK), R(0x1B3C, EXTEND),
+	R(0x1B3D, SPACINGMARK), R(0x1B42, EXTEND), R(0x1B43, SPACINGMARK),
+	R(0x1B45, OTHER), R(0x1B6B, EXTEND), R(0x1B74, OTHER),
+	R(0x1B80, EXTEND), R(0x1B82, SPACINGMARK), R(0x1B83, OTHER),
+	R(0x1BA1, SPACINGMARK), R(0x1BA2, EXTEND), R(0x1BA6, SPACINGMARK),
+	R(0x1BA8, EXTEND), R(0x1BAA, SPACINGMARK), R(0x1BAB, EXTEND),
+	R(0x1BAE, OTHER), R(0x1BE6, EXTEND), R(0x1BE7, SPACINGMARK),
+	R(0x1BE8, EXTEND), R(0x1BEA, SPACINGMARK), R(0x1BED, EXTEND),
+	R(0x1BEE, SPACINGMARK), R(0x1BEF, EXTEND), R(0x1BF2, SPACINGMARK),
+	R(0x1BF4, OTHER), R(0x1C24, SPACINGMARK), R(0x1C2C, EXTEND),
+	R(0x1C34, SPACINGMARK), R(0x1C36, EXTEND), R(0x1C38, OTHER),
+	R(0x1CD0, EXTEND), R(0x1CD3, OTHER), R(0x1CD4, EXTEND),
+	R(0x1CE1, SPACINGMARK), R(0x1CE2, EXTEND), R(0x1CE9, OTHER),
+	R(0x1CED, EXTEND), R(0x1CEE, OTHER), R(0x1CF4, EXTEND),
+	R(0x1CF5, OTHER), R(0x1CF7, SPACINGMARK), R(0x1CF8, EXTEND),
+	R(0x1CFA, OTHER), R(0x1DC0, EXTEND), R(0x1E00, OTHER),
+	R(0x200B, CONTROL), R(0x200C, EXTEND), R(0x200D, ZWJ),
+	R(0x200E, CONTROL), R(0x2010, OTHER), R(0x2028, CONTROL),
+	R(0x202F, OTHER), R(0x203C, PICTO), R(0x203D, OTHER), R(0x2049, PICTO),
+	R(0x204A, OTHER), R(0x2060, CONTROL), R(0x2070, OTHER),
+	R(0x20D0, EXTEND), R(0x20F1, OTHER), R(0x2122, PICTO), R(0x2123, OTHER),
+	R(0x2139, PICTO), R(0x213A, OTHER), R(0x2194, PICTO), R(0x219A, OTHER),
+	R(0x21A9, PICTO), R(0x21AB, OTHER), R(0x231A, PICTO), R(0x231C, OTHER),
+	R(0x2328, PICTO), R(0x2329, OTHER), R(0x2388, PICTO), R(0x2389, OTHER),
+	R(0x23CF, PICTO), R(0x23D0, OTHER), R(0x23E9, PICTO), R(0x23F4, OTHER),
+	R(0x23F8, PICTO), R(0x23FB, OTHER), R(0x24C2, PICTO), R(0x24C3, OTHER),
+	R(0x25AA, PICTO), R(0x25AC, OTHER), R(0x25B6, PICTO), R(0x25B7, OTHER),
+	R(0x25C0, PICTO), R(0x25C1, OTHER), R(0x25FB, PICTO), R(0x25FF, OTHER),
+	R(0x2600, PICTO), R(0x2606, OTHER), R(0x2607, PICTO), R(0x2613, OTHER),
+	R(0x2614, PICTO), R(0x2686, OTHER), R(0x2690, PICTO), R(0x2706, OTHER),
+	R(0x2708, PICTO), R(0x2713, OTHER), R(0x2714, PICTO), R(0x2715, OTHER),
+	R(0x2716, PICTO), R(0x2717, OTHER), R(0x271D, PICTO), R(0x271E, OTHER),
+	R(0x2721, PICTO), R(0x2722, OTHER), R(0x2728, PICTO), R(0x2729, OTHER),
+	R(0x2733, PICTO), R(0x2735, OTHER), R(0x2744, PICTO), R(0x2745, OTHER),
+	R(0x2747, PICTO), R(0x2748, OTHER), R(0x274C, PICTO), R(0x274D, OTHER),
+	R(0x274E, PICTO), R(0x274F, OTHER), R(0x2753, PICTO), R(0x2756, OTHER),
+	R(0x2757, PICTO), R(0x2758, OTHER), R(0x2763, PICTO), R(0x2768, OTHER),
+	R(0x2795, PICTO), R(0x2798, OTHER), R(0x27A1, PICTO), R(0x27A2, OTHER),
+	R(0x27B0, PICTO), R(0x27B1, OTHER), R(0x27BF, PICTO), R(0x27C0, OTHER),
+	R(0x2934, PICTO), R(0x2936, OTHER), R(0x2B05, PICTO), R(0x2B08, OTHER),
+	R(0x2B1B, PICTO), R(0x2B1D, OTHER), R(0x2B50, PICTO), R(0x2B51, OTHER),
+	R(0x2B55, PICTO), R(0x2B56, OTHER), R(0x2CEF, EXTEND), R(0x2CF2, OTHER),
+	R(0x2D7F, EXTEND), R(0x2D80, OTHER), R(0x2DE0, EXTEND),
+	R(0x2E00, OTHER), R(0x302A, EXTEND), R(0x3030, PICTO), R(0x3031, OTHER),
+	R(0x303D, PICTO), R(0x303E, OTHER), R(0x3099, EXTEND), R(0x309B, OTHER),
+	R(0x3297, PICTO), R(0x3298, OTHER), R(0x3299, PICTO), R(0x329A, OTHER),
+	R(0xA66F, EXTEND), R(0xA673, OTHER), R(0xA674, EXTEND),
+	R(0xA67E, OTHER), R(0xA69E, EXTEND), R(0xA6A0, OTHER),
+	R(0xA6F0, EXTEND), R(0xA6F2, OTHER), R(0xA802, EXTEND),
+	R(0xA803, OTHER), R(0xA806, EXTEND), R(0xA807, OTHER),
+	R(0xA80B, EXTEND), R(0xA80C, OTHER), R(0xA823, SPACINGMARK),
+	R(0xA825, EXTEND), R(0xA827, SPACINGMARK), R(0xA828, OTHER),
+	R(0xA82C, EXTEND), R(0xA82D, OTHER), R(0xA880, SPACINGMARK),
+	R(0xA882, OTHER), R(0xA8B4, SPACINGMARK), R(0xA8C4, EXTEND),
+	R(0xA8C6, OTHER), R(0xA8E0, EXTEND), R(0xA8F2, OTHER),
+	R(0xA8FF, EXTEND), R(0xA900, OTHER), R(0xA926, EXTEND),
+	R(0xA92E, OTHER), R(0xA947, EXTEND), R(0xA952, SPACINGMARK),
+	R(0xA954, OTHER), R(0xA960, L), R(0xA97D, OTHER), R(0xA980, EXTEND),
+	R(0xA983, SPACINGMARK), R(0xA984, OTHER), R(0xA9B3, EXTEND),
+	R(0xA9B4, SPACINGMARK), R(0xA9B6, EXTEND), R(0xA9BA, SPACINGMARK),
+	R(0xA9BC, EXTEND), R(0xA9BE, SPACINGMARK), R(0xA9C1, OTHER),
+	R(0xA9E5, EXTEND), R(0xA9E6, OTHER), R(0xAA29, EXTEND),
+	R(0xAA2F, SPACINGMARK), R(0xAA31, EXTEND), R(0xAA33, SPACINGMARK),
+	R(0xAA35, EXTEND), R(0xAA37, OTHER), R(0xAA43, EXTEND),
+	R(0xAA44, OTHER), R(0xAA4C, EXTEND), R(0xAA4D, SPACINGMARK),
+	R(0xAA4E, OTHER), R(0xAA7C, EXTEND), R(0xAA7D, OTHER),
+	R(0xAAB0, EXTEND), R(0xAAB1, OTHER), R(0xAAB2, EXTEND),
+	R(0xAAB5, OTHER), R(0xAAB7, EXTEND), R(0xAAB9, OTHER),
+	R(0xAABE, EXTEND), R(0xAAC0, OTHER), R(0xAAC1, EXTEND),
+	R(0xAAC2, OTHER), R(0xAAEB, SPACINGMARK), R(0xAAEC, EXTEND),
+	R(0xAAEE, SPACINGMARK), R(0xAAF0, OTHER), R(0xAAF5, SPACINGMARK),
+	R(0xAAF6, EXTEND), R(0xAAF7, OTHER), R(0xABE3, SPACINGMARK),
+	R(0xABE5, EXTEND), R(0xABE6, SPACINGMARK), R(0xABE8, EXTEND),
+	R(0xABE9, SPACINGMARK), R(0xABEB, OTHER), R(0xABEC, SPACINGMARK),
+	R(0xABED, EXTEND), R(0xABEE, OTHER), R(0xAC00, LV), R(0xD7A4, OTHER),
+	R(0xD7B0, V), R(0xD7C7, OTHER), R(0xD7CB, T), R(0xD7FC, OTHER),
+	R(0xFB1E, EXTEND), R(0xFB1F, OTHER), R(0xFE00, EXTEND),
+	R(0xFE10, OTHER), R(0xFE20, EXTEND), R(0xFE30, OTHER),
+	R(0xFEFF, CONTROL), R(0xFF00, OTHER), R(0xFF9E, EXTEND),
+	R(0xFFA0, OTHER), R(0xFFF0, CONTROL), R(0xFFFC, OTHER),
+	R(0x101FD, EXTEND), R(0x101FE, OTHER), R(0x102E0, EXTEND),
+	R(0x102E1, OTHER), R(0x10376, EXTEND), R(0x1037B, OTHER),
+	R(0x10A01, EXTEND), R(0x10A04, OTHER), R(0x10A05, EXTEND),
+	R(0x10A07, OTHER), R(0x10A0C, EXTEND), R(0x10A10, OTHER),
+	R(0x10A38, EXTEND), R(0x10A3B, OTHER), R(0x10A3F, EXTEND),
+	R(0x10A40, OTHER), R(0x10AE5, EXTEND), R(0x10AE7, OTHER),
+	R(0x10D24, EXTEND), R(0x10D28, OTHER), R(0x10EAB, EXTEND),
+	R(0x10EAD, OTHER), R(0x10F46, EXTEND), R(0x10F51, OTHER),
+	R(0x10F82, EXTEND), R(0x10F86, OTHER), R(0x11000, SPACINGMARK),
+	R(0x11001, EXTEND), R(0x11002, SPACINGMARK), R(0x11003, OTHER),
+	R(0x11038, EXTEND), R(0x11047, OTHER), R(0x11070, EXTEND),
+	R(0x11071, OTHER), R(0x11073, EXTEND), R(0x11075, OTHER),
+	R(0x1107F, EXTEND), R(0x11082, SPACINGMARK), R(0x11083, OTHER),
+	R(0x110B0, SPACINGMARK), R(0x110B3, EXTEND), R(0x110B7, SPACINGMARK),
+	R(0x110B9, EXTEND), R(0x110BB, OTHER), R(0x110BD, PREPEND),
+	R(0x110BE, OTHER), R(0x110C2, EXTEND), R(0x110C3, OTHER),
+	R(0x110CD, PREPEND), R(0x110CE, OTHER), R(0x11100, EXTEND),
+	R(0x11103, OTHER), R(0x11127, EXTEND), R(0x1112C, SPACINGMARK),
+	R(0x1112D, EXTEND), R(0x11135, OTHER), R(0x11145, SPACINGMARK),
+	R(0x11147, OTHER), R(0x11173, EXTEND), R(0x11174, OTHER),
+	R(0x11180, EXTEND), R(0x11182, SPACINGMARK), R(0x11183, OTHER),
+	R(0x111B3, SPACINGMARK), R(0x111B6, EXTEND), R(0x111BF, SPACINGMARK),
+	R(0x111C1, OTHER), R(0x111C2, PREPEND), R(0x111C4, OTHER),
+	R(0x111C9, EXTEND), R(0x111CD, OTHER), R(0x111CE, SPACINGMARK),
+	R(0x111CF, EXTEND), R(0x111D0, OTHER), R(0x1122C, SPACINGMARK),
+	R(0x1122F, EXTEND), R(0x11232, SPACINGMARK), R(0x11234, EXTEND),
+	R(0x11235, SPACINGMARK), R(0x11236, EXTEND), R(0x11238, OTHER),
+	R(0x1123E, EXTEND), R(0x1123F, OTHER), R(0x112DF, EXTEND),
+	R(0x112E0, SPACINGMARK), R(0x112E3, EXTEND), R(0x112EB, OTHER),
+	R(0x11300, EXTEND), R(0x11302, SPACINGMARK), R(0x11304, OTHER),
+	R(0x1133B, EXTEND), R(0x1133D, OTHER), R(0x1133E, EXTEND),
+	R(0x1133F, SPACINGMARK), R(0x11340, EXTEND), R(0x11341, SPACINGMARK),
+	R(0x11345, OTHER), R(0x11347, SPACINGMARK), R(0x11349, OTHER),
+	R(0x1134B, SPACINGMARK), R(0x1134E, OTHER), R(0x11357, EXTEND),
+	R(0x11358, OTHER), R(0x11362, SPACINGMARK), R(0x11364, OTHER),
+	R(0x11366, EXTEND), R(0x1136D, OTHER), R(0x11370, EXTEND),
+	R(0x11375, OTHER), R(0x11435, SPACINGMARK), R(0x11438, EXTEND),
+	R(0x11440, SPACINGMARK), R(0x11442, EXTEND), R(0x11445, SPACINGMARK),
+	R(0x11446, EXTEND), R(0x11447, OTHER), R(0x1145E, EXTEND),
+	R(0x1145F, OTHER), R(0x114B0, EXTEND), R(0x114B1, SPACINGMARK),
+	R(0x114B3, EXTEND), R(0x114B9, SPACINGMARK), R(0x114BA, EXTEND),
+	R(0x114BB, SPACINGMARK), R(0x114BD, EXTEND), R(0x114BE, SPACINGMARK),
+	R(0x114BF, EXTEND), R(0x114C1, SPACINGMARK), R(0x114C2, EXTEND),
+	R(0x114C4, OTHER), R(0x115AF, EXTEND), R(0x115B0, SPACINGMARK),
+	R(0x115B2, EXTEND), R(0x115B6, OTHER), R(0x115B8, SPACINGMARK),
+	R(0x115BC, EXTEND), R(0x115BE, SPACINGMARK), R(0x115BF, EXTEND),
+	R(0x115C1, OTHER), R(0x115DC, EXTEND), R(0x115DE, OTHER),
+	R(0x11630, SPACINGMARK), R(0x11633, EXTEND), R(0x1163B, SPACINGMARK),
+	R(0x1163D, EXTEND), R(0x1163E, SPACINGMARK), R(0x1163F, EXTEND),
+	R(0x11641, OTHER), R(0x116AB, EXTEND), R(0x116AC, SPACINGMARK),
+	R(0x116AD, EXTEND), R(0x116AE, SPACINGMARK), R(0x116B0, EXTEND),
+	R(0x116B6, SPACINGMARK), R(0x116B7, EXTEND), R(0x116B8, OTHER),
+	R(0x1171D, EXTEND), R(0x11720, OTHER), R(0x11722, EXTEND),
+	R(0x11726, SPACINGMARK), R(0x11727, EXTEND), R(0x1172C, OTHER),
+	R(0x1182C, SPACINGMARK), R(0x1182F, EXTEND), R(0x11838, SPACINGMARK),
+	R(0x11839, EXTEND), R(0x1183B, OTHER), R(0x11930, EXTEND),
+	R(0x11931, SPACINGMARK), R(0x11936, OTHER), R(0x11937, SPACINGMARK),
+	R(0x11939, OTHER), R(0x1193B, EXTEND), R(0x1193D, SPACINGMARK),
+	R(0x1193E, EXTEND), R(0x1193F, PREPEND), R(0x11940, SPACINGMARK),
+	R(0x11941, PREPEND), R(0x11942, SPACINGMARK), R(0x11943, EXTEND),
+	R(0x11944, OTHER), R(0x119D1, SPACINGMARK), R(0x119D4, EXTEND),
+	R(0x119D8, OTHER), R(0x119DA, EXTEND), R(0x119DC, SPACINGMARK),
+	R(0x119E0, EXTEND), R(0x119E1, OTHER), R(0x119E4, SPACINGMARK),
+	R(0x119E5, OTHER), R(0x11A01, EXTEND), R(0x11A0B, OTHER),
+	R(0x11A33, EXTEND), R(0x11A39, SPACINGMARK), R(0x11A3A, PREPEND),
+	R(0x11A3B, EXTEND), R(0x11A3F, OTHER), R(0x11A47, EXTEND),
+	R(0x11A48, OTHER), R(0x11A51, EXTEND), R(0x11A57, SPACINGMARK),
+	R(0x11A59, EXTEND), R(0x11A5C, OTHER), R(0x11A84, PREPEND),
+	R(0x11A8A, EXTEND), R(0x11A97, SPACINGMARK), R(0x11A98, EXTEND),
+	R(0x11A9A, OTHER), R(0x11C2F, SPACINGMARK), R(0x11C30, EXTEND),
+	R(0x11C37, OTHER), R(0x11C38, EXTEND), R(0x11C3E, SPACINGMARK),
+	R(0x11C3F, EXTEND), R(0x11C40, OTHER), R(0x11C92, EXTEND),
+	R(0x11CA8, OTHER), R(0x11CA9, SPACINGMARK), R(0x11CAA, EXTEND),
+	R(0x11CB1, SPACINGMARK), R(0x11CB2, EXTEND), R(0x11CB4, SPACINGMARK),
+	R(0x11CB5, EXTEND), R(0x11CB7, OTHER), R(0x11D31, EXTEND),
+	R(0x11D37, OTHER), R(0x11D3A, EXTEND), R(0x11D3B, OTHER),
+	R(0x11D3C, EXTEND), R(0x11D3E, OTHER), R(0x11D3F, EXTEND),
+	R(0x11D46, PREPEND), R(0x11D47, EXTEND), R(0x11D48, OTHER),
+	R(0x11D8A, SPACINGMARK), R(0x11D8F, OTHER), R(0x11D90, EXTEND),
+	R(0x11D92, OTHER), R(0x11D93, SPACINGMARK), R(0x11D95, EXTEND),
+	R(0x11D96, SPACINGMARK), R(0x11D97, EXTEND), R(0x11D98, OTHER),
+	R(0x11EF3, EXTEND), R(0x11EF5, SPACINGMARK), R(0x11EF7, OTHER),
+	R(0x13430, CONTROL), R(0x13439, OTHER), R(0x16AF0, EXTEND),
+	R(0x16AF5, OTHER), R(0x16B30, EXTEND), R(0x16B37, OTHER),
+	R(0x16F4F, EXTEND), R(0x16F50, OTHER), R(0x16F51, SPACINGMARK),
+	R(0x16F88, OTHER), R(0x16F8F, EXTEND), R(0x16F93, OTHER),
+	R(0x16FE4, EXTEND), R(0x16FE5, OTHER), R(0x16FF0, SPACINGMARK),
+	R(0x16FF2, OTHER), R(0x1BC9D, EXTEND), R(0x1BC9F, OTHER),
+	R(0x1BCA0, CONTROL), R(0x1BCA4, OTHER), R(0x1CF00, EXTEND),
+	R(0x1CF2E, OTHER), R(0x1CF30, EXTEND), R(0x1CF47, OTHER),
+	R(0x1D165, EXTEND), R(0x1D166, SPACINGMARK), R(0x1D167, EXTEND),
+	R(0x1D16A, OTHER), R(0x1D16D, SPACINGMARK), R(0x1D16E, EXTEND),
+	R(0x1D173, CONTROL), R(0x1D17B, EXTEND), R(0x1D183, OTHER),
+	R(0x1D185, EXTEND), R(0x1D18C, OTHER), R(0x1D1AA, EXTEND),
+	R(0x1D1AE, OTHER), R(0x1D242, EXTEND), R(0x1D245, OTHER),
+	R(0x1DA00, EXTEND), R(0x1DA37, OTHER), R(0x1DA3B, EXTEND),
+	R(0x1DA6D, OTHER), R(0x1DA75, EXTEND), R(0x1DA76, OTHER),
+	R(0x1DA84, EXTEND), R(0x1DA85, OTHER), R(0x1DA9B, EXTEND),
+	R(0x1DAA0, OTHER), R(0x1DAA1, EXTEND), R(0x1DAB0, OTHER),
+	R(0x1E000, EXTEND), R(0x1E007, OTHER), R(0x1E008, EXTEND),
+	R(0x1E019, OTHER), R(0x1E01B, EXTEND), R(0x1E022, OTHER),
+	R(0x1E023, EXTEND), R(0x1E025, OTHER), R(0x1E026, EXTEND),
+	R(0x1E02B, OTHER), R(0x1E130, EXTEND), R(0x1E137, OTHER),
+	R(0x1E2AE, EXTEND), R(0x1E2AF, OTHER), R(0x1E2EC, EXTEND),
+	R(0x1E2F0, OTHER), R(0x1E8D0, EXTEND), R(0x1E8D7, OTHER),
+	R(0x1E944, EXTEND), R(0x1E94B, OTHER), R(0x1F000, PICTO),
+	R(0x1F100, OTHER), R(0x1F10D, PICTO), R(0x1F110, OTHER),
+	R(0x1F12F, PICTO), R(0x1F130, OTHER), R(0x1F16C, PICTO),
+	R(0x1F172, OTHER), R(0x1F17E, PICTO), R(0x1F180, OTHER),
+	R(0x1F18E, PICTO), R(0x1F18F, OTHER), R(0x1F191, PICTO),
+	R(0x1F19B, OTHER), R(0x1F1AD, PICTO), R(0x1F1E6, RI), R(0x1F200, OTHER),
+	R(0x1F201, PICTO), R(0x1F210, OTHER), R(0x1F21A, PICTO),
+	R(0x1F21B, OTHER), R(0x1F22F, PICTO), R(0x1F230, OTHER),
+	R(0x1F232, PICTO), R(0x1F23B, OTHER), R(0x1F23C, PICTO),
+	R(0x1F240, OTHER), R(0x1F249, PICTO), R(0x1F3FB, EXTEND),
+	R(0x1F400, PICTO), R(0x1F53E, OTHER), R(0x1F546, PICTO),
+	R(0x1F650, OTHER), R(0x1F680, PICTO), R(0x1F700, OTHER),
+	R(0x1F774, PICTO), R(0x1F780, OTHER), R(0x1F7D5, PICTO),
+	R(0x1F800, OTHER), R(0x1F80C, PICTO), R(0x1F810, OTHER),
+	R(0x1F848, PICTO), R(0x1F850, OTHER), R(0x1F85A, PICTO),
+	R(0x1F860, OTHER), R(0x1F888, PICTO), R(0x1F890, OTHER),
+	R(0x1F8AE, PICTO), R(0x1F900, OTHER), R(0x1F90C, PICTO),
+	R(0x1F93B, OTHER), R(0x1F93C, PICTO), R(0x1F946, OTHER),
+	R(0x1F947, PICTO), R(0x1FB00, OTHER), R(0x1FC00, PICTO),
+	R(0x1FFFE, OTHER), R(0xE0000, CONTROL), R(0xE0020, EXTEND),
+	R(0xE0080, CONTROL), R(0xE0100, EXTEND), R(0xE01F0, CONTROL),
+	R(0xE1000, OTHER),
+};
+#undef R
+
+struct cprange { uint32_t from, to; };
+
+// East Asian Wide and Fullwidth codepoints, with the unassigned ones between
+static const struct cprange wide[] = {
+	{ 0x1100, 0x115F }, { 0x231A, 0x231B }, { 0x2329, 0x232A },
+	{ 0x23E9, 0x23EC }, { 0x23F0, 0x23F0 }, { 0x23F3, 0x23F3 },
+	{ 0x25FD, 0x25FE }, { 0x2614, 0x2615 }, { 0x2648, 0x2653 },
+	{ 0x267F, 0x267F }, { 0x2693, 0x2693 }, { 0x26A1, 0x26A1 },
+	{ 0x26AA, 0x26AB }, { 0x26BD, 0x26BE }, { 0x26C4, 0x26C5 },
+	{ 0x26CE, 0x26CE }, { 0x26D4, 0x26D4 }, { 0x26EA, 0x26EA },
+	{ 0x26F2, 0x26F3 }, { 0x26F5, 0x26F5 }, { 0x26FA, 0x26FA },
+	{ 0x26FD, 0x26FD }, { 0x2705, 0x2705 }, { 0x270A, 0x270B },
+	{ 0x2728, 0x2728 }, { 0x274C, 0x274C }, { 0x274E, 0x274E },
+	{ 0x2753, 0x2755 }, { 0x2757, 0x2757 }, { 0x2795, 0x2797 },
+	{ 0x27B0, 0x27B0 }, { 0x27BF, 0x27BF }, { 0x2B1B, 0x2B1C },
+	{ 0x2B50, 0x2B50 }, { 0x2B55, 0x2B55 }, { 0x2E80, 0x303E },
+	{ 0x3041, 0x3247 }, { 0x3250, 0x4DBF }, { 0x4E00, 0xA4C6 },
+	{ 0xA960, 0xA97C }, { 0xAC00, 0xD7A3 }, { 0xF900, 0xFAFF },
+	{ 0xFE10, 0xFE19 }, { 0xFE30, 0xFE6B }, { 0xFF01, 0xFF60 },
+	{ 0xFFE0, 0xFFE6 }, { 0x16FE0, 0x1B2FB }, { 0x1F004, 0x1F004 },
+	{ 0x1F0CF, 0x1F0CF }, { 0x1F18E, 0x1F18E }, { 0x1F191, 0x1F19A },
+	{ 0x1F200, 0x1F320 }, { 0x1F32D, 0x1F335 }, { 0x1F337, 0x1F37C },
+	{ 0x1F37E, 0x1F393 }, { 0x1F3A0, 0x1F3CA }, { 0x1F3CF, 0x1F3D3 },
+	{ 0x1F3E0, 0x1F3F0 }, { 0x1F3F4, 0x1F3F4 }, { 0x1F3F8, 0x1F43E },
+	{ 0x1F440, 0x1F440 }, { 0x1F442, 0x1F4FC }, { 0x1F4FF, 0x1F53D },
+	{ 0x1F54B, 0x1F54E }, { 0x1F550, 0x1F567 }, { 0x1F57A, 0x1F57A },
+	{ 0x1F595, 0x1F596 }, { 0x1F5A4, 0x1F5A4 }, { 0x1F5FB, 0x1F64F },
+	{ 0x1F680, 0x1F6C5 }, { 0x1F6CC, 0x1F6CC }, { 0x1F6D0, 0x1F6D2 },
+	{ 0x1F6D5, 0x1F6DF }, { 0x1F6EB, 0x1F6EC }, { 0x1F6F4, 0x1F6FC },
+	{ 0x1F7E0, 0x1F7F0 }, { 0x1F90C, 0x1F93A }, { 0x1F93C, 0x1F945 },
+	{ 0x1F947, 0x1F9FF }, { 0x1FA70, 0x1FAF6 }, { 0x20000, 0x3FFFD },
+};
+
+// nonspacing and enclosing marks and format characters (but the soft
+// hyphen), and Hangul vowels and finals joining a syllable
+static const struct cprange zero[] = {
+	{ 0x0300, 0x036F }, { 0x0483, 0x0489 }, { 0x0591, 0x05BD },
+	{ 0x05BF, 0x05BF }, { 0x05C1, 0x05C2 }, { 0x05C4, 0x05C5 },
+	{ 0x05C7, 0x05C7 }, { 0x0600, 0x0605 }, { 0x0610, 0x061A },
+	{ 0x061C, 0x061C }, { 0x064B, 0x065F }, { 0x0670, 0x0670 },
+	{ 0x06D6, 0x06DD }, { 0x06DF, 0x06E4 }, { 0x06E7, 0x06E8 },
+	{ 0x06EA, 0x06ED }, { 0x070F, 0x070F }, { 0x0711, 0x0711 },
+	{ 0x0730, 0x074A }, { 0x07A6, 0x07B0 }, { 0x07EB, 0x07F3 },
+	{ 0x07FD, 0x07FD }, { 0x0816, 0x0819 }, { 0x081B, 0x0823 },
+	{ 0x0825, 0x0827 }, { 0x0829, 0x082D }, { 0x0859, 0x085B },
+	{ 0x0890, 0x0891 }, { 0x0898, 0x089F }, { 0x08CA, 0x0902 },
+	{ 0x093A, 0x093A }, { 0x093C, 0x093C }, { 0x0941, 0x0948 },
+	{ 0x094D, 0x094D }, { 0x0951, 0x0957 }, { 0x0962, 0x0963 },
+	{ 0x0981, 0x0981 }, { 0x09BC, 0x09BC }, { 0x09C1, 0x09C4 },
+	{ 0x09CD, 0x09CD }, { 0x09E2, 0x09E3 }, { 0x09FE, 0x09FE },
+	{ 0x0A01, 0x0A02 }, { 0x0A3C, 0x0A3C }, { 0x0A41, 0x0A42 },
+	{ 0x0A47, 0x0A48 }, { 0x0A4B, 0x0A4D }, { 0x0A51, 0x0A51 },
+	{ 0x0A70, 0x0A71 }, { 0x0A75, 0x0A75 }, { 0x0A81, 0x0A82 },
+	{ 0x0ABC, 0x0ABC }, { 0x0AC1, 0x0AC5 }, { 0x0AC7, 0x0AC8 },
+	{ 0x0ACD, 0x0ACD }, { 0x0AE2, 0x0AE3 }, { 0x0AFA, 0x0AFF },
+	{ 0x0B01, 0x0B01 }, { 0x0B3C, 0x0B3C }, { 0x0B3F, 0x0B3F },
+	{ 0x0B41, 0x0B44 }, { 0x0B4D, 0x0B4D }, { 0x0B55, 0x0B56 },
+	{ 0x0B62, 0x0B63 }, { 0x0B82, 0x0B82 }, { 0x0BC0, 0x0BC0 },
+	{ 0x0BCD, 0x0BCD }, { 0x0C00, 0x0C00 }, { 0x0C04, 0x0C04 },
+	{ 0x0C3C, 0x0C3C }, { 0x0C3E, 0x0C40 }, { 0x0C46, 0x0C48 },
+	{ 0x0C4A, 0x0C4D }, { 0x0C55, 0x0C56 }, { 0x0C62, 0x0C63 },
+	{ 0x0C81, 0x0C81 }, { 0x0CBC, 0x0CBC }, { 0x0CBF, 0x0CBF },
+	{ 0x0CC6, 0x0CC6 }, { 0x0CCC, 0x0CCD }, { 0x0CE2, 0x0CE3 },
+	{ 0x0D00, 0x0D01 }, { 0x0D3B, 0x0D3C }, { 0x0D41, 0x0D44 },
+	{ 0x0D4D, 0x0D4D }, { 0x0D62, 0x0D63 }, { 0x0D81, 0x0D81 },
+	{ 0x0DCA, 0x0DCA }, { 0x0DD2, 0x0DD4 }, { 0x0DD6, 0x0DD6 },
+	{ 0x0E31, 0x0E31 }, { 0x0E34, 0x0E3A }, { 0x0E47, 0x0E4E },
+	{ 0x0EB1, 0x0EB1 }, { 0x0EB4, 0x0EBC }, { 0x0EC8, 0x0ECD },
+	{ 0x0F18, 0x0F19 }, { 0x0F35, 0x0F35 }, { 0x0F37, 0x0F37 },
+	{ 0x0F39, 0x0F39 }, { 0x0F71, 0x0F7E }, { 0x0F80, 0x0F84 },
+	{ 0x0F86, 0x0F87 }, { 0x0F8D, 0x0F97 }, { 0x0F99, 0x0FBC },
+	{ 0x0FC6, 0x0FC6 }, { 0x102D, 0x1030 }, { 0x1032, 0x1037 },
+	{ 0x1039, 0x103A }, { 0x103D, 0x103E }, { 0x1058, 0x1059 },
+	{ 0x105E, 0x1060 }, { 0x1071, 0x1074 }, { 0x1082, 0x1082 },
+	{ 0x1085, 0x1086 }, { 0x108D, 0x108D }, { 0x109D, 0x109D },
+	{ 0x1160, 0x11FF }, { 0x135D, 0x135F }, { 0x1712, 0x1714 },
+	{ 0x1732, 0x1733 }, { 0x1752, 0x1753 }, { 0x1772, 0x1773 },
+	{ 0x17B4, 0x17B5 }, { 0x17B7, 0x17BD }, { 0x17C6, 0x17C6 },
+	{ 0x17C9, 0x17D3 }, { 0x17DD, 0x17DD }, { 0x180B, 0x180F },
+	{ 0x1885, 0x1886 }, { 0x18A9, 0x18A9 }, { 0x1920, 0x1922 },
+	{ 0x1927, 0x1928 }, { 0x1932, 0x1932 }, { 0x1939, 0x193B },
+	{ 0x1A17, 0x1A18 }, { 0x1A1B, 0x1A1B }, { 0x1A56, 0x1A56 },
+	{ 0x1A58, 0x1A5E }, { 0x1A60, 0x1A60 }, { 0x1A62, 0x1A62 },
+	{ 0x1A65, 0x1A6C }, { 0x1A73, 0x1A7C }, { 0x1A7F, 0x1A7F },
+	{ 0x1AB0, 0x1ACE }, { 0x1B00, 0x1B03 }, { 0x1B34, 0x1B34 },
+	{ 0x1B36, 0x1B3A }, { 0x1B3C, 0x1B3C }, { 0x1B42, 0x1B42 },
+	{ 0x1B6B, 0x1B73 }, { 0x1B80, 0x1B81 }, { 0x1BA2, 0x1BA5 },
+	{ 0x1BA8, 0x1BA9 }, { 0x1BAB, 0x1BAD }, { 0x1BE6, 0x1BE6 },
+	{ 0x1BE8, 0x1BE9 }, { 0x1BED, 0x1BED }, { 0x1BEF, 0x1BF1 },
+	{ 0x1C2C, 0x1C33 }, { 0x1C36, 0x1C37 }, { 0x1CD0, 0x1CD2 },
+	{ 0x1CD4, 0x1CE0 }, { 0x1CE2, 0x1CE8 }, { 0x1CED, 0x1CED },
+	{ 0x1CF4, 0x1CF4 }, { 0x1CF8, 0x1CF9 }, { 0x1DC0, 0x1DFF },
+	{ 0x200B, 0x200F }, { 0x202A, 0x202E }, { 0x2060, 0x2064 },
+	{ 0x2066, 0x206F }, { 0x20D0, 0x20F0 }, { 0x2CEF, 0x2CF1 },
+	{ 0x2D7F, 0x2D7F }, { 0x2DE0, 0x2DFF }, { 0x302A, 0x302D },
+	{ 0x3099, 0x309A }, { 0xA66F, 0xA672 }, { 0xA674, 0xA67D },
+	{ 0xA69E, 0xA69F }, { 0xA6F0, 0xA6F1 }, { 0xA802, 0xA802 },
+	{ 0xA806, 0xA806 }, { 0xA80B, 0xA80B }, { 0xA825, 0xA826 },
+	{ 0xA82C, 0xA82C }, { 0xA8C4, 0xA8C5 }, { 0xA8E0, 0xA8F1 },
+	{ 0xA8FF, 0xA8FF }, { 0xA926, 0xA92D }, { 0xA947, 0xA951 },
+	{ 0xA980, 0xA982 }, { 0xA9B3, 0xA9B3 }, { 0xA9B6, 0xA9B9 },
+	{ 0xA9BC, 0xA9BD }, { 0xA9E5, 0xA9E5 }, { 0xAA29, 0xAA2E },
+	{ 0xAA31, 0xAA32 }, { 0xAA35, 0xAA36 }, { 0xAA43, 0xAA43 },
+	{ 0xAA4C, 0xAA4C }, { 0xAA7C, 0xAA7C }, { 0xAAB0, 0xAAB0 },
+	{ 0xAAB2, 0xAAB4 }, { 0xAAB7, 0xAAB8 }, { 0xAABE, 0xAABF },
+	{ 0xAAC1, 0xAAC1 }, { 0xAAEC, 0xAAED }, { 0xAAF6, 0xAAF6 },
+	{ 0xABE5, 0xABE5 }, { 0xABE8, 0xABE8 }, { 0xABED, 0xABED },
+	{ 0xD7B0, 0xD7C6 }, { 0xD7CB, 0xD7FB }, { 0xFB1E, 0xFB1E },
+	{ 0xFE00, 0xFE0F }, { 0xFE20, 0xFE2F }, { 0xFEFF, 0xFEFF },
+	{ 0xFFF9, 0xFFFB }, { 0x101FD, 0x101FD }, { 0x102E0, 0x102E0 },
+	{ 0x10376, 0x1037A }, { 0x10A01, 0x10A03 }, { 0x10A05, 0x10A06 },
+	{ 0x10A0C, 0x10A0F }, { 0x10A38, 0x10A3A }, { 0x10A3F, 0x10A3F },
+	{ 0x10AE5, 0x10AE6 }, { 0x10D24, 0x10D27 }, { 0x10EAB, 0x10EAC },
+	{ 0x10F46, 0x10F50 }, { 0x10F82, 0x10F85 }, { 0x11001, 0x11001 },
+	{ 0x11038, 0x11046 }, { 0x11070, 0x11070 }, { 0x11073, 0x11074 },
+	{ 0x1107F, 0x11081 }, { 0x110B3, 0x110B6 }, { 0x110B9, 0x110BA },
+	{ 0x110BD, 0x110BD }, { 0x110C2, 0x110C2 }, { 0x110CD, 0x110CD },
+	{ 0x11100, 0x11102 }, { 0x11127, 0x1112B }, { 0x1112D, 0x11134 },
+	{ 0x11173, 0x11173 }, { 0x11180, 0x11181 }, { 0x111B6, 0x111BE },
+	{ 0x111C9, 0x111CC }, { 0x111CF, 0x111CF }, { 0x1122F, 0x11231 },
+	{ 0x11234, 0x11234 }, { 0x11236, 0x11237 }, { 0x1123E, 0x1123E },
+	{ 0x112DF, 0x112DF }, { 0x112E3, 0x112EA }, { 0x11300, 0x11301 },
+	{ 0x1133B, 0x1133C }, { 0x11340, 0x11340 }, { 0x11366, 0x1136C },
+	{ 0x11370, 0x11374 }, { 0x11438, 0x1143F }, { 0x11442, 0x11444 },
+	{ 0x11446, 0x11446 }, { 0x1145E, 0x1145E }, { 0x114B3, 0x114B8 },
+	{ 0x114BA, 0x114BA }, { 0x114BF, 0x114C0 }, { 0x114C2, 0x114C3 },
+	{ 0x115B2, 0x115B5 }, { 0x115BC, 0x115BD }, { 0x115BF, 0x115C0 },
+	{ 0x115DC, 0x115DD }, { 0x11633, 0x1163A }, { 0x1163D, 0x1163D },
+	{ 0x1163F, 0x11640 }, { 0x116AB, 0x116AB }, { 0x116AD, 0x116AD },
+	{ 0x116B0, 0x116B5 }, { 0x116B7, 0x116B7 }, { 0x1171D, 0x1171F },
+	{ 0x11722, 0x11725 }, { 0x11727, 0x1172B }, { 0x1182F, 0x11837 },
+	{ 0x11839, 0x1183A }, { 0x1193B, 0x1193C }, { 0x1193E, 0x1193E },
+	{ 0x11943, 0x11943 }, { 0x119D4, 0x119D7 }, { 0x119DA, 0x119DB },
+	{ 0x119E0, 0x119E0 }, { 0x11A01, 0x11A0A }, { 0x11A33, 0x11A38 },
+	{ 0x11A3B, 0x11A3E }, { 0x11A47, 0x11A47 }, { 0x11A51, 0x11A56 },
+	{ 0x11A59, 0x11A5B }, { 0x11A8A, 0x11A96 }, { 0x11A98, 0x11A99 },
+	{ 0x11C30, 0x11C36 }, { 0x11C38, 0x11C3D }, { 0x11C3F, 0x11C3F },
+	{ 0x11C92, 0x11CA7 }, { 0x11CAA, 0x11CB0 }, { 0x11CB2, 0x11CB3 },
+	{ 0x11CB5, 0x11CB6 }, { 0x11D31, 0x11D36 }, { 0x11D3A, 0x11D3A },
+	{ 0x11D3C, 0x11D3D }, { 0x11D3F, 0x11D45 }, { 0x11D47, 0x11D47 },
+	{ 0x11D90, 0x11D91 }, { 0x11D95, 0x11D95 }, { 0x11D97, 0x11D97 },
+	{ 0x11EF3, 0x11EF4 }, { 0x13430, 0x13438 }, { 0x16AF0, 0x16AF4 },
+	{ 0x16B30, 0x16B36 }, { 0x16F4F, 0x16F4F }, { 0x16F8F, 0x16F92 },
+	{ 0x16FE4, 0x16FE4 }, { 0x1BC9D, 0x1BC9E }, { 0x1BCA0, 0x1BCA3 },
+	{ 0x1CF00, 0x1CF2D }, { 0x1CF30, 0x1CF46 }, { 0x1D167, 0x1D169 },
+	{ 0x1D173, 0x1D182 }, { 0x1D185, 0x1D18B }, { 0x1D1AA, 0x1D1AD },
+	{ 0x1D242, 0x1D244 }, { 0x1DA00, 0x1DA36 }, { 0x1DA3B, 0x1DA6C },
+	{ 0x1DA75, 0x1DA75 }, { 0x1DA84, 0x1DA84 }, { 0x1DA9B, 0x1DA9F },
+	{ 0x1DAA1, 0x1DAAF }, { 0x1E000, 0x1E006 }, { 0x1E008, 0x1E018 },
+	{ 0x1E01B, 0x1E021 }, { 0x1E023, 0x1E024 }, { 0x1E026, 0x1E02A },
+	{ 0x1E130, 0x1E136 }, { 0x1E2AE, 0x1E2AE }, { 0x1E2EC, 0x1E2EF },
+	{ 0x1E8D0, 0x1E8D6 }, { 0x1E944, 0x1E94A }, { 0xE0001, 0xE0001 },
+	{ 0xE0020, 0xE007F }, { 0xE0100, 0xE01EF },
+};
@@ -0,0 +1,113 @@
+#!/usr/bin/env perl
+# generates graphemes.h, the grapheme cluster break property of every
+# codepoint (UAX #29) as a table of ranges, and the codepoints taking two
+# columns or none, from perl's Unicode database:
+#   perl graphemes.pl > graphemes.h
+use strict;
+use warnings;
+use Unicode::UCD qw(prop_invmap);
+
+my %names = (
+	Other => 'OTHER', CR => 'CR', LF => 'LF', Control => 'CONTROL',
+	Extend => 'EXTEND', ZWJ => 'ZWJ', Regional_Indicator => 'RI',
+	Prepend => 'PREPEND', SpacingMark => 'SPACINGMARK', L => 'L', V => 'V',
+	T => 'T', LV => 'LV', LVT => 'LVT', ExtPict_XX => 'PICTO',
+);
+my ($list, $map) = prop_invmap('GCB');
+my ($ealist, $eamap) = prop_invmap('ea');
+my ($gclist, $gcmap) = prop_invmap('gc');
+my ($hstlist, $hstmap) = prop_invmap('hst');
+
+sub inlist {
+	my ($cp, $l) = @_;
+	my ($lo, $hi) = (0, scalar @$l);
+	while($lo < $hi) {
+		my $mid = int(($lo + $hi) / 2);
+		if($l->[$mid] <= $cp) { $lo = $mid + 1 } else { $hi = $mid }
+	}
+	return $lo;
+}
+
+my @ranges;
+for(my $cp = 0; $cp <= 0x10FFFF; $cp++) {
+	my $prop = $names{$map->[inlist($cp, $list) - 1]} or die "GCB of $cp";
+	# syllables alternate LV and LVT, told apart by gcb_of
+	$prop = 'LV' if $cp >= 0xAC00 && $cp <= 0xD7A3;
+	push @ranges, [$cp, $prop] if !@ranges || $ranges[-1][1] ne $prop;
+}
+
+sub of {
+	my ($cp, $l, $m) = @_;
+	return $m->[inlist($cp, $l) - 1];
+}
+
+# wide: East Asian Wide and Fullwidth, merged over the unassigned codepoints
+# in between. zero: nonspacing and enclosing marks and format characters
+# (but the soft hyphen), and Hangul vowels and finals joining a syllable
+my (@wide, @zero);
+my $gap = 0; # only unassigned codepoints since the last wide one
+for(my $cp = 0; $cp <= 0x10FFFF; $cp++) {
+	my $ea = of($cp, $ealist, $eamap);
+	my $gc = of($cp, $gclist, $gcmap);
+	my $hst = of($cp, $hstlist, $hstmap);
+	if($ea eq 'W' || $ea eq 'F') {
+		if($gap) { $wide[-1][1] = $cp } else { push @wide, [$cp, $cp] }
+		$gap = 1;
+	} elsif($gc ne 'Cn') {
+		$gap = 0;
+	}
+	if(($gc =~ /^(Mn|Me|Cf)$/ && $cp != 0xAD) || $hst eq 'V' || $hst eq 'T') {
+		if(@zero && $zero[-1][1] == $cp - 1) { $zero[-1][1] = $cp }
+		else { push @zero, [$cp, $cp] }
+	}
+}
+
+# items joined into lines of at most 72 columns
+sub wrap {
+	my $line = "";
+	for my $item (@_) {
+		if(length($line) + length($item) + 1 > 72) {
+			print "\t$line\n";
+			$line = "";
+		}
+		$line .= ($line ? " " : "") . $item;
+	}
+	print "\t$line\n" if $line;
+}
+
+printf "// generated by graphemes.pl from Unicode %s, do not edit\n\n",
+	Unicode::UCD::UnicodeVersion();
+print <<'END';
+#pragma once
+#include <stdint.h>
+
+enum gcb {
+	GCB_OTHER, GCB_CR, GCB_LF, GCB_CONTROL, GCB_EXTEND, GCB_ZWJ, GCB_RI,
+	GCB_PREPEND, GCB_SPACINGMARK, GCB_L, GCB_V, GCB_T, GCB_LV, GCB_LVT,
+	GCB_PICTO, // Extended_Pictographic
+};
+
+#define R(from, prop) ((uint32_t)(from) << 8 | GCB_##prop)
+// the property of codepoints from each start up to the next one's
+static const uint32_t gcb_ranges[] = {
+END
+wrap(map { sprintf "R(0x%X, %s),", @$_ } @ranges);
+print "};\n#undef R\n";
+
+print <<'END';
+
+struct cprange { uint32_t from, to; };
+
+// East Asian Wide and Fullwidth codepoints, with the unassigned ones between
+static const struct cprange wide[] = {
+END
+wrap(map { sprintf "{ 0x%04X, 0x%04X },", @$_ } @wide);
+print <<'END';
+};
+
+// nonspacing and enclosing marks and format characters (but the soft
+// hyphen), and Hangul vowels and finals joining a syllable
+static const struct cprange zero[] = {
+END
+wrap(map { sprintf "{ 0x%04X, 0x%04X },", @$_ } @zero);
+print "};\n";
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <sys/types.h>
+#include <sys/uio.h>
 
 #define MAX(a,b) ((a)>(b)?(a):(b))
 #define MIN(a,b) ((a)<(b)?(a):(b))
@@ -30,6 +33,226 @@ size_t st_size(const SliceTable *st);
 bool st_insert(SliceTable *st, size_t pos, const char *data, size_t len);
 bool st_delete(SliceTable *st, size_t pos, size_t len);
 
+// copy up to len bytes from pos into buf, returning the number copied
+size_t st_read(const SliceTable *st, size_t pos, size_t len, char *buf);
+// as st_read into a NUL terminated buffer to be freed by the caller
+char *st_read_alloc0(const SliceTable *st, size_t pos, size_t len);
+// calls cb on each piece of [from, to) in order until it returns false,
+// returning whether the whole range was visited
+typedef bool (*st_chunk_cb)(const char *data, size_t len, void *ctx);
+bool st_foreach_chunk(const SliceTable *st, size_t from, size_t to,
+						st_chunk_cb cb, void *ctx);
+// points up to max entries of out at the slices covering [pos, pos+len),
+// returning how many. *next (if non-NULL) is where to continue, pos+len once
+// the range is covered. The pointers are valid until st is modified or freed,
+// so take a st_clone to keep them while editing
+size_t st_iovec(const SliceTable *st, size_t pos, size_t len,
+				struct iovec *out, size_t max, size_t *next);
+
+// write the contents to fd at its current offset, returning the number of
+// bytes written or -1 with errno set. Unmodified text in a mapped file is
+// copied in-kernel where possible
+ssize_t st_write(const SliceTable *st, int fd);
+ssize_t st_write_range(const SliceTable *st, int fd, size_t pos, size_t len);
+
+// how st_write and saves issue writes. by default large ranges are written
+// by a thread per core with pwrite at each subtree's offset, and io_uring is
+// used for fragmented tables. writev is the fallback
+enum st_writer {
+	ST_WRITER_AUTO, ST_WRITER_WRITEV, ST_WRITER_URING, ST_WRITER_PARALLEL
+};
+void st_set_writer(enum st_writer backend);
+
+/* metrics */
+
+// a summary of text kept per subtree, e.g. a count. Summaries of adjacent
+// text combine into one of both (a monoid), so any range can be summarized
+// in O(log n) plus the slices at its ends
+#define ST_METRIC_FIELDS 8
+#define ST_MAX_METRICS 8
+typedef struct stmetric {
+	int fields; // size_ts in a summary
+	// the summary of data[0, len). When len is 0, the identity
+	void (*measure)(size_t *sum, const char *data, size_t len);
+	// sum = sum followed by next. NULL if the fields just add up, which lets
+	// the summaries of large slices be reused by subtracting
+	void (*combine)(size_t *sum, const size_t *next);
+	// for st_metric_seek, if field 0 adds up: the offset of the count'th unit
+	// in data[0, len) or len if fewer, subtracting those passed from *count
+	size_t (*seek)(const char *data, size_t len, size_t *count);
+} StMetric;
+
+extern const StMetric st_newlines;
+// of UTF-8 text, malformed sequences counting a codepoint per lead byte
+extern const StMetric st_codepoints;
+extern const StMetric st_utf16; // code units, 2 per codepoint outside the BMP
+// in bytes without newlines: newlines, the first line's length, the last's
+// and the longest's strictly in between. Seeks lines like st_newlines
+extern const StMetric st_line_lengths;
+// nesting of (), [] and {}, each on its own: per class, closers without
+// openers before them and openers without closers after them
+extern const StMetric st_brackets;
+
+// starts keeping metric for st, returning its index or -1. This summarizes
+// the whole table. Edits then summarize only what they touched. Clones share
+// the summaries. Tables without metrics keep none
+int st_add_metric(SliceTable *st, const StMetric *metric);
+// summarizes [from, to) into sum
+void st_summarize(const SliceTable *st, int metric, size_t from, size_t to,
+					size_t *sum);
+// the offset of the count'th unit (from 1), or st_size if there are fewer
+size_t st_metric_seek(const SliceTable *st, int metric, size_t count);
+
+/* marks */
+
+// positions kept sorted outside the tree, e.g. cursors and diagnostics, that
+// move with the text on every edit. Each edit costs one pass over them
+typedef struct stmarks StMarks;
+enum st_mark_flags {
+	// at insertions at the mark, move after the text instead of staying before
+	ST_MARK_RIGHT = 1,
+	// delete the mark with the text around it instead of moving it to the start
+	ST_MARK_DELETE = 2,
+};
+
+// attaches a mark array to st. It's detached when st is freed
+StMarks *st_marks_new(SliceTable *st);
+void st_marks_free(StMarks *marks);
+// returns the mark's id or SIZE_MAX. Ids are reused once removed
+size_t st_mark_add(StMarks *marks, size_t pos, int flags);
+void st_mark_remove(StMarks *marks, size_t id);
+// moves the mark, bringing it back if it was deleted
+bool st_mark_move(StMarks *marks, size_t id, size_t pos);
+// SIZE_MAX if the mark was deleted with its text
+size_t st_mark_pos(const StMarks *marks, size_t id);
+// the positions of the marks in order, valid until the next edit or change
+const size_t *st_marks_sorted(const StMarks *marks, size_t *n);
+
+// replaces deleted bytes at pos with len bytes of data
+struct st_edit {
+	size_t pos, deleted;
+	const char *data;
+	size_t len;
+};
+// applies edits sorted by pos, not overlapping, with positions from before
+// the batch, or returns false and changes nothing if they aren't. Marks and
+// decorations move as if the edits were applied one by one, front to back.
+// Marks do so in one pass
+bool st_edit_batch(SliceTable *st, const struct st_edit *edits, size_t n);
+
+/* decorations */
+
+// ranges with an id, e.g. highlights and diagnostics, kept with st in a
+// persistent interval tree. Edits move them in O(log n) plus the ones they
+// touch, and clones share them. Text replaced at a decoration's start or end
+// ends up inside it
+enum st_deco_flags {
+	// grow with insertions at the end instead of ending before them
+	ST_DECO_GROW = 1,
+	// delete the decoration with its text instead of leaving it empty
+	ST_DECO_DELETE = 2,
+};
+#define ST_DECO_ANY SIZE_MAX
+
+// false if the range is out of bounds or memory ran out. Should it run out
+// while an edit or removal moves them, st's decorations are all dropped
+bool st_deco_add(SliceTable *st, size_t start, size_t end, size_t id,
+				int flags);
+// removes those with id (or any) overlapping [from, to), returning how many
+size_t st_deco_remove(SliceTable *st, size_t from, size_t to, size_t id);
+// calls cb on the decorations overlapping [from, to) by their starts until it
+// returns false, returning whether all were visited. Empty ones overlap where
+// they are. O(log n) plus those visited for the ranges of a viewport
+typedef bool (*st_deco_cb)(size_t start, size_t end, size_t id, int flags,
+							void *ctx);
+bool st_foreach_deco(const SliceTable *st, size_t from, size_t to,
+					st_deco_cb cb, void *ctx);
+
+/* positions */
+
+// lines, codepoints and UTF-16 units are numbered from 0. Counting from
+// from (0, or a line's start for the columns language servers use) scans the
+// range unless st keeps the metric (st_newlines, st_codepoints or st_utf16),
+// making it O(log n) plus a scan of the slices at its ends
+
+// adds st_newlines to st
+void st_enable_lines(SliceTable *st);
+// the start of line, or st_size if there are fewer lines
+size_t st_line_to_pos(const SliceTable *st, size_t line);
+// the number of newlines before pos
+size_t st_pos_to_line(const SliceTable *st, size_t pos);
+// the number of codepoints starting in [from, pos)
+size_t st_pos_to_cp(const SliceTable *st, size_t from, size_t pos);
+// the start of the cp'th codepoint from from, or st_size if there are fewer
+size_t st_cp_to_pos(const SliceTable *st, size_t from, size_t cp);
+size_t st_pos_to_utf16(const SliceTable *st, size_t from, size_t pos);
+// the start of the codepoint with the unit'th unit from from
+size_t st_utf16_to_pos(const SliceTable *st, size_t from, size_t unit);
+// the length in bytes of the longest line in [from, to), counting the parts
+// of lines in the range. O(log n) if st keeps st_line_lengths, and O(1) for
+// the whole table
+size_t st_longest_line(const SliceTable *st, size_t from, size_t to);
+// the position of the bracket matching the one at pos, or SIZE_MAX if there's
+// none or no bracket at pos. Strings and comments aren't told apart. O(log n)
+// plus a scan of the slices at the ends if st keeps st_brackets
+size_t st_match_bracket(const SliceTable *st, size_t pos);
+// the innermost (, [ or { before pos without its closer before pos, and its
+// closer, or st_size if it has none. Returns false if there isn't one
+bool st_enclosing_brackets(const SliceTable *st, size_t pos, size_t *open,
+							size_t *close);
+
+// counts the newlines of st's mapped files and large insertions on a worker
+// thread. The counts are kept with the text, so line queries and
+// st_enable_lines on st and all its clones skip over whatever has been counted
+typedef struct stlinejob StLineJob;
+StLineJob *st_count_lines_async(const SliceTable *st);
+// returns whether counting is over, finished or cancelled. done/total are
+// in bytes
+bool st_line_job_poll(const StLineJob *job, size_t *done, size_t *total);
+void st_line_job_cancel(StLineJob *job);
+// joins and frees the job
+void st_line_job_wait(StLineJob *job);
+
+/* saving */
+
+enum st_save_method {
+	// in-place when only appending to the file st was loaded from,
+	// otherwise atomic, falling back to in-place (e.g. for hard links)
+	ST_SAVE_AUTO,
+	// write a temporary file and rename(2) it over path
+	ST_SAVE_ATOMIC,
+	// overwrite path, skipping text that is unchanged from when it was mapped
+	ST_SAVE_INPLACE,
+};
+
+typedef struct stsave StSave;
+
+// every st_save_begin must be matched by one st_save_commit/st_save_cancel
+// st must not be modified in between
+StSave *st_save_begin(SliceTable *st, const char *path,
+						enum st_save_method method);
+bool st_save_commit(StSave *save);
+void st_save_cancel(StSave *save);
+bool st_save(SliceTable *st, const char *path, enum st_save_method method);
+
+// saves a snapshot of st on a worker thread, so st may be edited or freed
+// immediately. Everything, including copying a mapping of the file that must
+// survive the save, happens on the worker. cb (if any) runs there once the
+// save is over
+typedef struct stsavejob StSaveJob;
+typedef void (*st_save_cb)(bool ok, void *ctx);
+
+StSaveJob *st_save_async(const SliceTable *st, const char *path,
+						enum st_save_method method, st_save_cb cb, void *ctx);
+// becomes readable on progress and completion, drained by st_save_job_poll
+int st_save_job_fd(const StSaveJob *job);
+// returns whether the save is over. done/total are in bytes
+bool st_save_job_poll(StSaveJob *job, size_t *done, size_t *total);
+// the save fails with ECANCELED. n.b. in-place saves are left partial
+void st_save_job_cancel(StSaveJob *job);
+// joins and frees the job, returning whether the save succeeded
+bool st_save_job_wait(StSaveJob *job);
+
 bool st_check_invariants(const SliceTable *st);
 void st_pprint(const SliceTable *st);
 void st_dump(const SliceTable *st, FILE *file);
@@ -41,13 +264,23 @@ size_t st_node_count(const SliceTable *st);
 /* read-only iterator */
 
 // it is an error to call any of st_iter_* except st_iter_free after the
-// SliceTable instance has been freed or modified
+// SliceTable instance has been freed or modified, unless the iterator is pinned
 
 SliceIter *st_iter_init(SliceIter *it, SliceTable *st, size_t pos);
 SliceIter *st_iter_new(SliceTable *st, size_t pos);
+// iterates over a snapshot of st, so st may be modified or freed meanwhile,
+// including from another thread. st_iter_st returns the snapshot
+SliceIter *st_iter_new_pinned(const SliceTable *st, size_t pos);
 void st_iter_free(SliceIter *it);
 // reinitializes the iterator
 SliceIter *st_iter_to(SliceIter *it, size_t pos);
+// moves iterators over a table just edited by deleting deleted bytes at pos,
+// then inserting inserted bytes there. Those in the deleted range go to pos,
+// those after it (or at pos) move with the text after it. Only iterators
+// whose slice was changed search from the root, or all of them if the edit
+// moved slices or nodes within the tree. Pinned iterators are left alone
+void st_iter_fixup(SliceIter **its, size_t n,
+					size_t pos, size_t deleted, size_t inserted);
 
 SliceTable *st_iter_st(const SliceIter *it);
 size_t st_iter_pos(const SliceIter *it);
@@ -55,6 +288,8 @@ size_t st_iter_pos(const SliceIter *it);
 char *st_iter_chunk(const SliceIter *it, size_t *len);
 bool st_iter_next_chunk(SliceIter *it);
 bool st_iter_prev_chunk(SliceIter *it);
+// copies like st_read, leaving the iterator after the last byte copied
+size_t st_iter_read(SliceIter *it, size_t len, char *buf);
 
 int st_iter_byte(const SliceIter *it);
 int st_iter_next_byte(SliceIter *it, size_t count);
@@ -64,7 +299,21 @@ long st_iter_cp(const SliceIter *it);
 long st_iter_next_cp(SliceIter *it, size_t count);
 long st_iter_prev_cp(SliceIter *it, size_t count);
 
+// moves over count extended grapheme clusters (UAX #29), i.e. what users see
+// as characters, from the start of one. Returns false if the end (or the
+// start) came first. Stepping through ASCII is as fast as stepping bytes
+bool st_iter_next_grapheme(SliceIter *it, size_t count);
+bool st_iter_prev_grapheme(SliceIter *it, size_t count);
+
 bool st_iter_next_line(SliceIter *it, size_t count);
 bool st_iter_prev_line(SliceIter *it, size_t count);
 
-//size_t st_iter_visual_col(const SliceIter *it);
+// the display column of the iterator in its line, from 0. Tabs reach the
+// next multiple of tabwidth (> 0), East Asian wide characters take two and
+// combining marks and format characters none. Runs of other characters are
+// measured a vector at a time
+size_t st_iter_visual_col(const SliceIter *it, int tabwidth);
+// moves to the character taking up display column col in the iterator's
+// line, or to the line's end, returning that character's column, which is
+// less than col if it's wide or a tab. For moving the cursor between lines
+size_t st_iter_to_visual_col(SliceIter *it, size_t col, int tabwidth);